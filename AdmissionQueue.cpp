@@ -0,0 +1,63 @@
+//
+//  AdmissionQueue.cpp
+//  CloudSim
+//
+
+
+#include "AdmissionQueue.hpp"
+
+
+unsigned AdmissionQueue::MemoryClass(unsigned needed) {
+   unsigned memory_class = 0;
+   while (needed) {
+      memory_class++;
+      needed >>= 1;
+   }
+   return memory_class;
+}
+
+
+void AdmissionQueue::Push(const TaskInfo_t & task_info, Time_t latest_start) {
+   PendingTask task = {latest_start, task_info.task_id, task_info.required_memory + VM_MEMORY_OVERHEAD, task_info.required_vm};
+   Push(task_info.required_cpu, task);
+}
+
+
+void AdmissionQueue::Push(CPUType_t cpu, const PendingTask & task) {
+   buckets[cpu][task.vm_type][MemoryClass(task.needed)].push(task);
+   pending[cpu]++;
+}
+
+
+bool AdmissionQueue::PopFitting(CPUType_t cpu, unsigned available, PendingTask & task) {
+   if (pending[cpu] == 0) return false;
+
+   // Every task in a class below the class of `available` fits, the class of
+   // `available` itself may or may not, and nothing above it can.
+   unsigned top_class = MemoryClass(available);
+   Bucket * best = nullptr;
+   for (unsigned vm = 0; vm < NUM_VM_TYPES; vm++) {
+      for (unsigned memory_class = 0; memory_class <= top_class; memory_class++) {
+         Bucket & bucket = buckets[cpu][vm][memory_class];
+         if (bucket.empty() || bucket.top().needed > available) continue;
+         if (best == nullptr || MoreUrgent()(best->top(), bucket.top())) {
+            best = &bucket;
+         }
+      }
+   }
+   if (best == nullptr) return false;
+
+   task = best->top();
+   best->pop();
+   pending[cpu]--;
+   return true;
+}
+
+
+unsigned AdmissionQueue::Size() const {
+   unsigned size = 0;
+   for (unsigned cpu = 0; cpu < NUM_CPU_TYPES; cpu++) {
+      size += pending[cpu];
+   }
+   return size;
+}
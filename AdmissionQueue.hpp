@@ -0,0 +1,65 @@
+//
+//  AdmissionQueue.hpp
+//  CloudSim
+//
+//  Tasks that could not be placed when they arrived wait here until capacity
+//  frees up. The queue is bucketed by required CPU, VM type and memory class
+//  (the bit width of the memory the task needs), and every bucket is a
+//  min-heap on the latest time the task can start and still meet its target.
+//  Draining for a machine only looks at bucket heads, never at the whole queue.
+//
+
+
+#ifndef AdmissionQueue_hpp
+#define AdmissionQueue_hpp
+
+
+#include <queue>
+#include <vector>
+
+#include "FreeMemoryIndex.hpp"
+#include "Interfaces.h"
+
+
+#define NUM_VM_TYPES 4
+#define MEMORY_CLASSES 33
+
+
+struct PendingTask {
+   Time_t latest_start;        // target completion minus the best-case runtime
+   TaskId_t task_id;
+   unsigned needed;            // task memory plus the overhead of a VM
+   VMType_t vm_type;
+};
+
+
+class AdmissionQueue {
+public:
+   AdmissionQueue()            {}
+
+   void Push(const TaskInfo_t & task_info, Time_t latest_start);
+   void Push(CPUType_t cpu, const PendingTask & task);
+
+   // Pops the most urgent task of the given CPU type whose memory fits in
+   // `available`. Only the heads of the buckets are inspected, so a task
+   // stuck behind a larger one in the same memory class waits for the next drain.
+   bool PopFitting(CPUType_t cpu, unsigned available, PendingTask & task);
+
+   bool Empty(CPUType_t cpu) const { return pending[cpu] == 0; }
+   unsigned Size() const;
+private:
+   struct MoreUrgent {
+      bool operator()(const PendingTask & a, const PendingTask & b) const {
+         return a.latest_start != b.latest_start ? a.latest_start > b.latest_start : a.task_id > b.task_id;
+      }
+   };
+   typedef std::priority_queue<PendingTask, std::vector<PendingTask>, MoreUrgent> Bucket;
+
+   Bucket buckets[NUM_CPU_TYPES][NUM_VM_TYPES][MEMORY_CLASSES];
+   unsigned pending[NUM_CPU_TYPES] = {};
+
+   static unsigned MemoryClass(unsigned needed);
+};
+
+
+#endif /* AdmissionQueue_hpp */
@@ -0,0 +1,166 @@
+//
+//  Async.cpp
+//  CloudSim
+//
+
+
+#include "Async.hpp"
+
+#include <new>
+
+
+FramePool::FreeFrame * FramePool::free_lists[FramePool::CLASSES] = {};
+size_t FramePool::live = 0;
+size_t FramePool::reserved = 0;
+
+
+void * FramePool::Allocate(size_t size) {
+   live++;
+   size_t size_class = (size + GRANULE - 1) / GRANULE;
+   if (size_class >= CLASSES) {
+      reserved += size;
+      return ::operator new(size);
+   }
+
+   FreeFrame *& free_list = free_lists[size_class];
+   if (free_list == nullptr) {
+      // Carve a chunk into frames of this class
+      size_t frame_size = size_class * GRANULE;
+      char * chunk = static_cast<char *>(::operator new(CHUNK));
+      reserved += CHUNK;
+      for (size_t offset = 0; offset + frame_size <= CHUNK; offset += frame_size) {
+         FreeFrame * frame = reinterpret_cast<FreeFrame *>(chunk + offset);
+         frame->next = free_list;
+         free_list = frame;
+      }
+   }
+   FreeFrame * frame = free_list;
+   free_list = frame->next;
+   return frame;
+}
+
+
+void FramePool::Free(void * frame, size_t size) {
+   live--;
+   size_t size_class = (size + GRANULE - 1) / GRANULE;
+   if (size_class >= CLASSES) {
+      reserved -= size;
+      ::operator delete(frame);
+      return;
+   }
+   FreeFrame * free_frame = static_cast<FreeFrame *>(frame);
+   free_frame->next = free_lists[size_class];
+   free_lists[size_class] = free_frame;
+}
+
+
+bool StateChange::await_ready() {
+   bool pending = ops.state_waiters.Contains(machine_id) && ops.state_waiters.Get(machine_id).head != nullptr;
+   if (pending || Machine_GetInfo(machine_id).s_state != waiter.state) return false;
+   waiter.time = Now();
+   return true;
+}
+
+
+void StateChange::await_suspend(std::coroutine_handle<> plan) {
+   waiter.plan = plan;
+   AsyncOps::StateWaiter & waiters = ops.state_waiters[machine_id];
+   bool issue = waiters.head == nullptr || waiters.requested != waiter.state;
+   waiter.next = waiters.head;
+   waiters.head = &waiter;
+   ops.waiting++;
+   if (issue) {
+      // Linked first: the simulator may report a trivial change before returning
+      waiters.requested = waiter.state;
+      Machine_SetState(machine_id, waiter.state);
+   }
+}
+
+
+void Migration::await_suspend(std::coroutine_handle<> plan) {
+   waiter.plan = plan;
+   waiter.time = Now();
+   Waiter *& head = ops.migration_waiters[vm_id];
+   waiter.next = head;
+   head = &waiter;
+   ops.waiting++;
+   VM_Migrate(vm_id, destination);
+}
+
+
+AsyncOps::~AsyncOps() {
+   // Plans still waiting when the simulation ends are torn down with their frames
+   for (MachineId_t machine_id : state_waiters.Keys()) {
+      for (Waiter * waiter = state_waiters.Get(machine_id).head; waiter != nullptr;) {
+         Waiter * next = waiter->next;
+         waiter->plan.destroy();
+         waiter = next;
+      }
+   }
+   for (VMId_t vm_id : migration_waiters.Keys()) {
+      for (Waiter * waiter = migration_waiters.Get(vm_id); waiter != nullptr;) {
+         Waiter * next = waiter->next;
+         waiter->plan.destroy();
+         waiter = next;
+      }
+   }
+}
+
+
+void AsyncOps::StateChanged(Time_t now, MachineId_t machine_id) {
+   if (!state_waiters.Contains(machine_id) || state_waiters.Get(machine_id).head == nullptr) return;
+
+   // Detach the list first: resumed plans may wait on this machine again
+   MachineState_t reached = Machine_GetInfo(machine_id).s_state;
+   Waiter * list = Reversed(state_waiters.Get(machine_id).head);
+   state_waiters.Get(machine_id).head = nullptr;
+   Waiter * kept = nullptr;
+   while (list != nullptr) {
+      Waiter * waiter = list;
+      list = waiter->next;                 // the waiter lives in the frame, which may be gone after resuming
+      if (waiter->state != reached) {
+         waiter->next = kept;
+         kept = waiter;
+         continue;
+      }
+      waiter->time = now;
+      waiting--;
+      resumed++;
+      waiter->plan.resume();
+   }
+
+   // The plans still waiting are older than any that arrived while resuming,
+   // and the list runs from the newest, so they go at its end
+   Waiter ** tail = &state_waiters.Get(machine_id).head;
+   while (*tail != nullptr) tail = &(*tail)->next;
+   *tail = kept;
+}
+
+
+void AsyncOps::Migrated(Time_t now, VMId_t vm_id) {
+   if (!migration_waiters.Contains(vm_id)) return;
+   Waiter * list = Reversed(migration_waiters.Get(vm_id));
+   migration_waiters.Erase(vm_id);
+   while (list != nullptr) {
+      Waiter * waiter = list;
+      list = waiter->next;
+      migrations++;
+      migration_time += double(now - waiter->time);
+      waiter->time = now;
+      waiting--;
+      resumed++;
+      waiter->plan.resume();
+   }
+}
+
+
+Waiter * AsyncOps::Reversed(Waiter * list) {
+   Waiter * reversed = nullptr;
+   while (list != nullptr) {
+      Waiter * next = list->next;
+      list->next = reversed;
+      reversed = list;
+      list = next;
+   }
+   return reversed;
+}
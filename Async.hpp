@@ -0,0 +1,161 @@
+//
+//  Async.hpp
+//  CloudSim
+//
+//  Coroutine layer over the simulator's asynchronous operations. A policy
+//  writes a multi-step plan as one coroutine returning Plan and awaits the
+//  operations it depends on:
+//
+//     Plan Scheduler::Relocate(VMId_t vm_id, MachineId_t destination) {
+//        MachineId_t source = machine_vms.OwnerOf(vm_id);
+//        migrating_vms.Insert(vm_id);
+//        decisions.Record(Now(), DECISION_VM_MIGRATE, vm_id, destination);
+//        Time_t time = co_await async.Migrate(vm_id, destination);
+//
+//        // The VM now can receive new tasks, and its tasks count towards the destination
+//        migrating_vms.Erase(vm_id);
+//        ...
+//     }
+//
+//  The awaited operation is started when the plan suspends, and the plan is
+//  resumed from StateChanged() or Migrated() once the simulator
+//  reports it done; co_await yields the completion time. Plans start running
+//  as soon as they are called and free themselves when they return. Frames
+//  come from a pool of fixed size classes, and a waiting plan is linked into
+//  the wait list through its awaiter, which lives in the frame, so neither
+//  starting a plan nor waiting allocates once the pool has warmed up.
+//  Everything here runs on the scheduler's thread.
+//
+
+
+#ifndef Async_hpp
+#define Async_hpp
+
+
+#include <coroutine>
+#include <cstddef>
+
+#include "DenseId.hpp"
+#include "Interfaces.h"
+
+
+// Size-class free lists for coroutine frames; memory is kept for reuse, never returned
+class FramePool {
+public:
+   static void * Allocate(size_t size);
+   static void Free(void * frame, size_t size);
+   static size_t Live()        { return live; }
+   static size_t Reserved()    { return reserved; }  // bytes taken from the heap
+private:
+   static const size_t GRANULE = 64;
+   static const size_t CLASSES = 32;                  // frames up to 2 KB are pooled
+   static const size_t CHUNK = 64 * 1024;
+   struct FreeFrame {
+      FreeFrame * next;
+   };
+   static FreeFrame * free_lists[CLASSES];
+   static size_t live;
+   static size_t reserved;
+};
+
+
+// Return type of a plan; the coroutine owns itself, so there is nothing to hold on to
+struct Plan {
+   struct promise_type {
+      Plan get_return_object()                     { return {}; }
+      std::suspend_never initial_suspend() noexcept   { return {}; }
+      std::suspend_never final_suspend() noexcept     { return {}; }
+      void return_void()                           {}
+      void unhandled_exception()                   { throw; }
+      static void * operator new(size_t size)      { return FramePool::Allocate(size); }
+      static void operator delete(void * frame, size_t size)  { FramePool::Free(frame, size); }
+   };
+};
+
+
+class AsyncOps;
+
+
+// A suspended plan, linked into the wait list of a machine or VM
+struct Waiter {
+   std::coroutine_handle<> plan;
+   Waiter * next = nullptr;
+   Time_t time = 0;            // when the operation started, then its completion time once the plan resumes
+   MachineState_t state = S0;  // the state a StateChange waits for
+};
+
+
+class StateChange {
+public:
+   StateChange(AsyncOps & ops, MachineId_t machine_id, MachineState_t state) : ops(ops), machine_id(machine_id) {
+      waiter.state = state;
+   }
+   bool await_ready();
+   void await_suspend(std::coroutine_handle<> plan);
+   Time_t await_resume() const { return waiter.time; }
+private:
+   AsyncOps & ops;
+   MachineId_t machine_id;
+   Waiter waiter;
+};
+
+
+class Migration {
+public:
+   Migration(AsyncOps & ops, VMId_t vm_id, MachineId_t destination) : ops(ops), vm_id(vm_id), destination(destination) {}
+   bool await_ready() const    { return false; }
+   void await_suspend(std::coroutine_handle<> plan);
+   Time_t await_resume() const { return waiter.time; }
+private:
+   AsyncOps & ops;
+   VMId_t vm_id;
+   MachineId_t destination;
+   Waiter waiter;
+};
+
+
+class AsyncOps {
+public:
+   AsyncOps()                  {}
+   ~AsyncOps();
+   AsyncOps(const AsyncOps &) = delete;
+   AsyncOps & operator=(const AsyncOps &) = delete;
+
+   // Plans waiting for the same state of a machine share one request. A plan
+   // asking for a state the machine is already in (with nothing pending) does
+   // not suspend. A plan resumes only once the machine has reached its state,
+   // so one waiting for a state that a later request overrode keeps waiting.
+   StateChange SetMachineState(MachineId_t machine_id, MachineState_t state)   { return StateChange(*this, machine_id, state); }
+   StateChange WakeMachine(MachineId_t machine_id)     { return StateChange(*this, machine_id, S0); }
+   Migration Migrate(VMId_t vm_id, MachineId_t destination)   { return Migration(*this, vm_id, destination); }
+
+   // Forward the simulator's StateChangeComplete() and MigrationDone() callbacks here; the plans
+   // waiting on them resume before these return. The names differ from the callbacks' so that
+   // builds which rename the callbacks with macros (the benchmark driver) leave these alone.
+   void StateChanged(Time_t now, MachineId_t machine_id);
+   void Migrated(Time_t now, VMId_t vm_id);
+
+   unsigned Waiting() const    { return waiting; }
+   uint64_t Resumed() const    { return resumed; }
+   // Mean time a migration has taken so far, 0 before the first one completes
+   Time_t MigrationLatency() const   { return migrations ? Time_t(migration_time / migrations) : 0; }
+private:
+   friend class StateChange;
+   friend class Migration;
+
+   struct StateWaiter {
+      Waiter * head = nullptr;
+      MachineState_t requested = S0;
+   };
+   IdMap<MachineId_t, StateWaiter> state_waiters;
+   IdMap<VMId_t, Waiter *> migration_waiters;
+   unsigned waiting = 0;
+   uint64_t resumed = 0;
+   uint64_t migrations = 0;
+   double migration_time = 0;
+
+   static Waiter * Reversed(Waiter * list);
+};
+
+
+#endif /* Async_hpp */
@@ -0,0 +1,241 @@
+//
+//  Bench.cpp
+//  CloudSim
+//
+//  Benchmark driver. It takes the place of main.cpp. The policy is compiled
+//  with its entry points renamed to Policy_* (see BENCH_RENAME in the
+//  Makefile) and the driver provides the real entry points in front of them,
+//  so every event the simulator delivers to the policy is counted and
+//  HandleNewTask is timed, whatever policy is linked in. At every
+//  SchedulerCheck the machines running at least one task are counted, for
+//  the mean and peak number of active machines (a machine on its way to
+//  sleep still reports S0, so the power state would overcount). Counting
+//  reads every machine, so its time is taken out of the simulation time and
+//  the event rate, which measure the simulator and the policy only. Each run
+//  prints one JSON object per line.
+//
+//  Usage: bench [-v level] [-n label] [-o output] (-m machines -t tasks | input_file)
+//
+
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "Interfaces.h"
+#include "Internal_Interfaces.h"
+#include "WorkloadGen.hpp"
+
+
+using Clock = std::chrono::steady_clock;
+
+static unsigned verbose = 0;
+
+static uint64_t events = 0;
+static uint64_t new_tasks = 0;
+static uint64_t new_task_ns = 0;
+static uint64_t new_task_max_ns = 0;
+static uint64_t checks = 0;
+static uint64_t active_total = 0;
+static unsigned active_peak = 0;
+static uint64_t counting_ns = 0;       // spent by the driver counting active machines
+static Clock::time_point start_time;
+static Clock::time_point scheduler_ready;
+static Clock::time_point simulation_done;
+
+
+// Debugging interface, normally provided by main.cpp
+
+void SimOutput(string msg, unsigned verbose_level) {
+   if (verbose_level <= verbose) {
+      cout << msg << endl;
+   }
+}
+
+void ThrowException(string err_msg) {
+   throw runtime_error(err_msg);
+}
+
+void ThrowException(string err_msg, string further_input) {
+   throw runtime_error(err_msg + further_input);
+}
+
+void ThrowException(string err_msg, unsigned further_input) {
+   throw runtime_error(err_msg + to_string(further_input));
+}
+
+
+// Scheduler interface in front of the policy
+
+extern void Policy_InitScheduler();
+extern void Policy_HandleNewTask(Time_t time, TaskId_t task_id);
+extern void Policy_HandleTaskCompletion(Time_t time, TaskId_t task_id);
+extern void Policy_MemoryWarning(Time_t time, MachineId_t machine_id);
+extern void Policy_MigrationDone(Time_t time, VMId_t vm_id);
+extern void Policy_SchedulerCheck(Time_t time);
+extern void Policy_SimulationComplete(Time_t time);
+extern void Policy_SLAWarning(Time_t time, TaskId_t task_id);
+extern void Policy_StateChangeComplete(Time_t time, MachineId_t machine_id);
+
+void InitScheduler() {
+   Policy_InitScheduler();
+   scheduler_ready = Clock::now();
+}
+
+void HandleNewTask(Time_t time, TaskId_t task_id) {
+   events++;
+   new_tasks++;
+   Clock::time_point before = Clock::now();
+   Policy_HandleNewTask(time, task_id);
+   uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - before).count();
+   new_task_ns += elapsed;
+   new_task_max_ns = max(new_task_max_ns, elapsed);
+}
+
+void HandleTaskCompletion(Time_t time, TaskId_t task_id)        { events++; Policy_HandleTaskCompletion(time, task_id); }
+void MemoryWarning(Time_t time, MachineId_t machine_id)         { events++; Policy_MemoryWarning(time, machine_id); }
+void MigrationDone(Time_t time, VMId_t vm_id)                   { events++; Policy_MigrationDone(time, vm_id); }
+void SLAWarning(Time_t time, TaskId_t task_id)                  { events++; Policy_SLAWarning(time, task_id); }
+void StateChangeComplete(Time_t time, MachineId_t machine_id)   { events++; Policy_StateChangeComplete(time, machine_id); }
+
+void SchedulerCheck(Time_t time) {
+   events++;
+   Policy_SchedulerCheck(time);
+   Clock::time_point before = Clock::now();
+   unsigned active = 0;
+   for (unsigned i = 0; i < Machine_GetTotal(); i++) {
+      if (Machine_GetInfo(MachineId_t(i)).active_tasks > 0) active++;
+   }
+   counting_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - before).count();
+   checks++;
+   active_total += active;
+   active_peak = max(active_peak, active);
+}
+
+void SimulationComplete(Time_t time) {
+   simulation_done = Clock::now();
+   Policy_SimulationComplete(time);
+}
+
+
+// A synthetic cluster that alternates the two machine classes of
+// Testcases/Day, with Poisson arrivals spread over 100 simulated seconds.
+static string SyntheticInput(unsigned machines, uint64_t tasks) {
+   stringstream classes;
+   unsigned large = (machines + 1) / 2;
+   classes << "machine class:\n{\n        Number of machines: " << large << "\n"
+           << "        CPU type: X86\n        Number of cores: 8\n        Memory: 16384\n"
+           << "        S-States: [120, 100, 100, 80, 40, 10, 0]\n        P-States: [12, 8, 6, 4]\n"
+           << "        C-States: [12, 3, 1, 0]\n        MIPS: [3000, 2400, 2000, 1500]\n        GPUs: no\n}\n";
+   if (machines > large) {
+      classes << "machine class:\n{\n        Number of machines: " << machines - large << "\n"
+              << "        CPU type: X86\n        Number of cores: 4\n        Memory: 8192\n"
+              << "        S-States: [40, 20, 16, 12, 10, 4, 0]\n        P-States: [4, 2, 2, 1]\n"
+              << "        C-States: [4, 1, 1, 0]\n        MIPS: [1500, 1200, 1000, 600]\n        GPUs: no\n}\n";
+   }
+
+   WorkloadClass workload;
+   workload.start = 60000;
+   workload.end = workload.start + 100000000;
+   workload.rate = double(tasks) / 100.0;
+   workload.segment_length = workload.end;
+   workload.mixture = 1;
+   workload.runtime.mean = 1000000;
+   workload.memory.mean = 8;
+   workload.seed = 520230;
+
+   string filename = "/tmp/cloudsim_bench_" + to_string(getpid()) + ".md";
+   ofstream out(filename);
+   WriteWorkload(out, {workload}, classes.str());
+   return filename;
+}
+
+
+int main(int argc, char * argv[]) {
+   string label = "Scheduler";
+   string output;
+   unsigned machines = 0;
+   uint64_t tasks = 0;
+
+   int opt;
+   while ((opt = getopt(argc, argv, "v:n:o:m:t:")) != -1) {
+      switch (opt) {
+         case 'v': verbose = unsigned(atoi(optarg)); break;
+         case 'n': label = optarg; break;
+         case 'o': output = optarg; break;
+         case 'm': machines = unsigned(atoi(optarg)); break;
+         case 't': tasks = strtoull(optarg, nullptr, 10); break;
+         default:
+            cerr << "Usage: " << argv[0] << " [-v level] [-n label] [-o output] (-m machines -t tasks | input_file)" << endl;
+            return 1;
+      }
+   }
+
+   string input;
+   bool synthetic = machines > 0 && tasks > 0;
+   if (synthetic) {
+      input = SyntheticInput(machines, tasks);
+   } else if (optind < argc) {
+      input = argv[optind];
+   } else {
+      cerr << "Usage: " << argv[0] << " [-v level] [-n label] [-o output] (-m machines -t tasks | input_file)" << endl;
+      return 1;
+   }
+
+   // The policy's own report goes to cout; keep it out of the results
+   stringstream discarded;
+   streambuf * console = verbose ? nullptr : cout.rdbuf(discarded.rdbuf());
+
+   start_time = Clock::now();
+   try {
+      Init(input);
+   } catch (const exception & e) {
+      if (console) cout.rdbuf(console);
+      cerr << "bench: " << e.what() << endl;
+      return 1;
+   }
+   Clock::time_point end_time = Clock::now();
+   if (console) cout.rdbuf(console);
+   if (synthetic) remove(input.c_str());
+
+   struct rusage usage;
+   getrusage(RUSAGE_SELF, &usage);
+
+   double startup_ms = std::chrono::duration<double, std::milli>(scheduler_ready - start_time).count();
+   double simulate_s = std::chrono::duration<double>(simulation_done - scheduler_ready).count() - counting_ns / 1e9;
+   double total_s = std::chrono::duration<double>(end_time - start_time).count();
+
+   stringstream record;
+   record << "{\"policy\": \"" << label << "\""
+          << ", \"input\": \"" << (synthetic ? "synthetic" : input) << "\""
+          << ", \"machines\": " << Machine_GetTotal()
+          << ", \"tasks\": " << GetNumTasks()
+          << ", \"startup_ms\": " << startup_ms
+          << ", \"simulate_s\": " << simulate_s
+          << ", \"total_s\": " << total_s
+          << ", \"events\": " << events
+          << ", \"events_per_s\": " << (simulate_s > 0 ? events / simulate_s : 0)
+          << ", \"new_task_calls\": " << new_tasks
+          << ", \"ns_per_new_task\": " << (new_tasks ? new_task_ns / new_tasks : 0)
+          << ", \"max_ns_new_task\": " << new_task_max_ns
+          << ", \"peak_rss_kb\": " << usage.ru_maxrss
+          << ", \"active_machines_mean\": " << (checks ? double(active_total) / checks : 0)
+          << ", \"active_machines_peak\": " << active_peak
+          << ", \"counting_s\": " << counting_ns / 1e9
+          << ", \"energy_kwh\": " << Machine_GetClusterEnergy()
+          << ", \"sla0\": " << GetSLAReport(SLA0)
+          << ", \"sla1\": " << GetSLAReport(SLA1)
+          << ", \"sla2\": " << GetSLAReport(SLA2)
+          << "}";
+
+   if (output.empty()) {
+      cout << record.str() << endl;
+   } else {
+      ofstream(output, ios::app) << record.str() << endl;
+   }
+   return 0;
+}
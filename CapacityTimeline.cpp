@@ -0,0 +1,136 @@
+//
+//  CapacityTimeline.cpp
+//  CloudSim
+//
+
+
+#include "CapacityTimeline.hpp"
+
+
+void CapacityTimeline::Init(unsigned total_machines) {
+   releases.assign(total_machines, {});
+   reserved.assign(total_machines, 0);
+   ready.assign(size_t(total_machines) * CLASSES, NEVER);
+   indexed.assign(total_machines, false);
+   cpu_of.resize(total_machines);
+   for (unsigned i = 0; i < total_machines; i++) {
+      cpu_of[i] = Machine_GetCPUType(MachineId_t(i));
+      Update(MachineId_t(i));
+   }
+}
+
+
+// Smallest k with 2^k >= needed
+unsigned CapacityTimeline::MemoryClass(unsigned needed) {
+   return needed <= 1 ? 0 : unsigned(32 - __builtin_clz(needed - 1));
+}
+
+
+void CapacityTimeline::Started(MachineId_t machine_id, TaskId_t task_id, unsigned memory, Time_t finish) {
+   running[task_id] = {machine_id, memory, finish};
+   releases[machine_id].insert({finish, task_id});
+   Update(machine_id);
+}
+
+
+void CapacityTimeline::Completed(TaskId_t task_id) {
+   auto it = running.find(task_id);
+   if (it == running.end()) return;
+   Hold task = it->second;
+   running.erase(it);
+   releases[task.machine_id].erase({task.finish, task_id});
+   Update(task.machine_id);
+}
+
+
+void CapacityTimeline::Moved(TaskId_t task_id, MachineId_t destination) {
+   auto it = running.find(task_id);
+   if (it == running.end() || it->second.machine_id == destination) return;
+   Hold & task = it->second;
+   releases[task.machine_id].erase({task.finish, task_id});
+   releases[destination].insert({task.finish, task_id});
+   task.machine_id = destination;
+}
+
+
+void CapacityTimeline::Reserve(MachineId_t machine_id, TaskId_t task_id, unsigned memory) {
+   holds[task_id] = {machine_id, memory, 0};
+   reserved[machine_id] += memory;
+   Update(machine_id);
+}
+
+
+bool CapacityTimeline::Fulfil(TaskId_t task_id) {
+   auto it = holds.find(task_id);
+   if (it == holds.end()) return false;
+   Hold hold = it->second;
+   holds.erase(it);
+   reserved[hold.machine_id] -= hold.memory;
+   fulfilled++;
+   Update(hold.machine_id);
+   return true;
+}
+
+
+void CapacityTimeline::Update(MachineId_t machine_id) {
+   Remove(machine_id);
+
+   MachineInfo_t m_info = Machine_GetInfo(machine_id);
+   if (m_info.s_state != S0) return;
+
+   // Walk the machine's completions in order; every class is reached at the
+   // first step where that much memory is free and a core is idle. Memory held
+   // past what is free now is a debt the first completions pay off.
+   int64_t available = int64_t(m_info.memory_size) - int64_t(m_info.memory_used) - int64_t(reserved[machine_id]);
+   unsigned busy = m_info.active_tasks;
+   Time_t * times = &ready[size_t(machine_id) * CLASSES];
+   unsigned reached = 0;
+   auto release = releases[machine_id].begin();
+   Time_t time = 0;
+   while (true) {
+      while (reached < CLASSES && busy < m_info.num_cpus && available >= 0 && (uint64_t(1) << reached) <= uint64_t(available)) {
+         times[reached] = time;
+         by_class[cpu_of[machine_id]][reached].insert({time, machine_id});
+         reached++;
+      }
+      if (reached == CLASSES || release == releases[machine_id].end()) break;
+      time = release->first;
+      available += running.find(release->second)->second.memory;
+      busy = busy > 0 ? busy - 1 : 0;
+      release++;
+   }
+   indexed[machine_id] = true;
+}
+
+
+void CapacityTimeline::Remove(MachineId_t machine_id) {
+   if (!indexed[machine_id]) return;
+   Time_t * times = &ready[size_t(machine_id) * CLASSES];
+   for (unsigned k = 0; k < CLASSES && times[k] != NEVER; k++) {
+      by_class[cpu_of[machine_id]][k].erase({times[k], machine_id});
+      times[k] = NEVER;
+   }
+   indexed[machine_id] = false;
+}
+
+
+bool CapacityTimeline::Earliest(CPUType_t cpu, unsigned needed, const IdSet<MachineId_t> & powered_on, Time_t & time,
+                                MachineId_t & host) const {
+   unsigned memory_class = MemoryClass(needed);
+   if (memory_class >= CLASSES) return false;
+
+   // A machine on its way down still reports S0 and stays filed until it is removed
+   for (const auto & entry : by_class[cpu][memory_class]) {
+      if (!powered_on.Contains(entry.second)) continue;
+      time = entry.first;
+      host = entry.second;
+      return true;
+   }
+   return false;
+}
+
+
+unsigned CapacityTimeline::Held(MachineId_t machine_id, TaskId_t task_id) const {
+   auto it = holds.find(task_id);
+   return it != holds.end() && it->second.machine_id == machine_id ? it->second.memory : 0;
+}
@@ -0,0 +1,87 @@
+//
+//  CapacityTimeline.hpp
+//  CloudSim
+//
+//  Projected capacity of every powered-on machine. Each running task is
+//  filed with its predicted completion, so a machine's free memory and free
+//  cores over future time are a step function: what it has now plus what
+//  its tasks give back as they finish. Memory promised to queued tasks
+//  (reservations) is taken off the whole curve until they are placed.
+//
+//  For every CPU type and memory class (the power of two at or above the
+//  memory asked for) the machines are kept in a set ordered by the earliest
+//  time they will have that much memory and a free core, so the earliest
+//  host for a task is the head of one set. Refiling a machine walks its own
+//  completions only.
+//
+
+
+#ifndef CapacityTimeline_hpp
+#define CapacityTimeline_hpp
+
+
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "DenseId.hpp"
+#include "FreeMemoryIndex.hpp"
+#include "Interfaces.h"
+
+
+class CapacityTimeline {
+public:
+   CapacityTimeline()          {}
+   void Init(unsigned total_machines);
+
+   // Call after the task's memory has been charged to the machine
+   void Started(MachineId_t machine_id, TaskId_t task_id, unsigned memory, Time_t finish);
+   void Completed(TaskId_t task_id);
+   // The task's VM migrated; refiles its completion under the destination.
+   // Update() both machines afterwards.
+   void Moved(TaskId_t task_id, MachineId_t destination);
+   // Holds `memory` on the machine for a queued task until Fulfil()
+   void Reserve(MachineId_t machine_id, TaskId_t task_id, unsigned memory);
+   // The task has been placed (on any machine); false if it held nothing
+   bool Fulfil(TaskId_t task_id);
+
+   // Re-reads the machine and refiles it. Machines that are not in S0 are dropped.
+   void Update(MachineId_t machine_id);
+   void Remove(MachineId_t machine_id);
+
+   // Machine in `powered_on` of the given CPU type that will soonest have
+   // `needed` memory free and a core to spare, and from when. Times in the
+   // past mean now.
+   bool Earliest(CPUType_t cpu, unsigned needed, const IdSet<MachineId_t> & powered_on, Time_t & time, MachineId_t & host) const;
+
+   unsigned Reserved(MachineId_t machine_id) const   { return reserved[machine_id]; }
+   // Memory the task holds on the machine, 0 if it holds nothing there
+   unsigned Held(MachineId_t machine_id, TaskId_t task_id) const;
+   unsigned Reservations() const                     { return unsigned(holds.size()); }
+   uint64_t Fulfilled() const                        { return fulfilled; }
+private:
+   static const unsigned CLASSES = 33;
+   static constexpr Time_t NEVER = Time_t(-1);
+
+   struct Hold {
+      MachineId_t machine_id;
+      unsigned memory;
+      Time_t finish;
+   };
+   // Live and queued tasks only, which are few next to the ids a trace issues
+   std::unordered_map<TaskId_t, Hold> running;
+   std::unordered_map<TaskId_t, Hold> holds;
+   vector<std::set<std::pair<Time_t, TaskId_t>>> releases;   // per machine, by predicted completion
+   vector<unsigned> reserved;
+   vector<Time_t> ready;       // per machine and class, when it is reached (NEVER if not)
+   vector<CPUType_t> cpu_of;
+   vector<bool> indexed;
+   std::set<std::pair<Time_t, MachineId_t>> by_class[NUM_CPU_TYPES][CLASSES];
+   uint64_t fulfilled = 0;
+
+   static unsigned MemoryClass(unsigned needed);
+};
+
+
+#endif /* CapacityTimeline_hpp */
@@ -0,0 +1,68 @@
+//
+//  ChangeFeed.cpp
+//  CloudSim
+//
+
+
+#include "ChangeFeed.hpp"
+
+
+void ChangeFeed::Init(unsigned total_machines, double memory_threshold) {
+   this->memory_threshold = memory_threshold;
+   snapshots.assign(total_machines, MachineSnapshot());
+   for (unsigned i = 0; i < total_machines; i++) {
+      Refresh(0, MachineId_t(i));
+   }
+}
+
+
+void ChangeFeed::Refresh(Time_t now, MachineId_t machine_id) {
+   MachineInfo_t m_info = Machine_GetInfo(machine_id);
+   MachineSnapshot & snapshot = snapshots[machine_id];
+
+   bool idle = m_info.s_state == S0 && m_info.active_tasks == 0 && m_info.active_vms == 0;
+   bool above = m_info.memory_used > memory_threshold * m_info.memory_size;
+   // Only cores that were all busy before count as freed
+   unsigned busy_before = min(snapshot.active_tasks, snapshot.num_cpus);
+   unsigned busy_now = min(m_info.active_tasks, m_info.num_cpus);
+
+   bool state_changed = m_info.s_state != snapshot.s_state;
+   bool idle_changed = idle != snapshot.idle;
+   bool above_changed = above != snapshot.above_threshold;
+   bool cores_freed = snapshot.active_tasks >= snapshot.num_cpus && snapshot.num_cpus > 0 && busy_now < busy_before;
+
+   snapshot.active_tasks = m_info.active_tasks;
+   snapshot.num_cpus = m_info.num_cpus;
+   snapshot.memory_used = m_info.memory_used;
+   snapshot.s_state = m_info.s_state;
+   snapshot.p_state = m_info.p_state;
+   snapshot.idle = idle;
+   snapshot.above_threshold = above;
+
+   for (ChangeListener * listener : listeners) {
+      if (state_changed) listener->MachineStateChanged(now, machine_id, m_info.s_state);
+      if (idle_changed) {
+         if (idle) listener->MachineIdle(now, machine_id);
+         else listener->MachineBusy(now, machine_id);
+      }
+      if (above_changed) listener->MemoryThreshold(now, machine_id, above);
+      if (cores_freed) listener->CoresFreed(now, machine_id, busy_before - busy_now);
+   }
+}
+
+
+void ChangeFeed::RefreshVM(Time_t now, VMId_t vm_id, MachineId_t machine_id) {
+   if (vm_id >= vm_tasks.size()) {
+      vm_tasks.resize(vm_id + 1, 0);
+   }
+   unsigned active = unsigned(VM_GetInfo(vm_id).active_tasks.size());
+   bool emptied = vm_tasks[vm_id] > 0 && active == 0;
+   bool occupied = vm_tasks[vm_id] == 0 && active > 0;
+   vm_tasks[vm_id] = active;
+
+   for (ChangeListener * listener : listeners) {
+      if (emptied) listener->VMEmptied(now, vm_id, machine_id);
+      if (occupied) listener->VMOccupied(now, vm_id, machine_id);
+   }
+   Refresh(now, machine_id);
+}
@@ -0,0 +1,73 @@
+//
+//  ChangeFeed.hpp
+//  CloudSim
+//
+//  Change notifications for policies. The feed keeps a small snapshot of every
+//  machine and VM; whenever the scheduler has touched one (a task placed or
+//  completed, a migration or a state change finished) it calls Refresh() and
+//  the feed compares the new state with the snapshot and tells its listeners
+//  what changed. Policies keep their idle sets and the like up to date from
+//  these callbacks instead of scanning the whole cluster.
+//
+
+
+#ifndef ChangeFeed_hpp
+#define ChangeFeed_hpp
+
+
+#include <vector>
+
+#include "Interfaces.h"
+
+
+// Override the notifications you care about, the rest are ignored
+class ChangeListener {
+public:
+   virtual ~ChangeListener()   {}
+   // No tasks and no VMs on a machine in S0
+   virtual void MachineIdle(Time_t now, MachineId_t machine_id)                       {}
+   virtual void MachineBusy(Time_t now, MachineId_t machine_id)                       {}
+   virtual void MachineStateChanged(Time_t now, MachineId_t machine_id, MachineState_t state) {}
+   virtual void VMEmptied(Time_t now, VMId_t vm_id, MachineId_t machine_id)            {}
+   virtual void VMOccupied(Time_t now, VMId_t vm_id, MachineId_t machine_id)           {}
+   // Memory use went above (or back below) the feed's threshold
+   virtual void MemoryThreshold(Time_t now, MachineId_t machine_id, bool above)       {}
+   // Tasks left a machine that had no idle core
+   virtual void CoresFreed(Time_t now, MachineId_t machine_id, unsigned cores)         {}
+};
+
+
+class ChangeFeed {
+public:
+   ChangeFeed()                {}
+   // `memory_threshold` is the fraction of a machine's memory that counts as full
+   void Init(unsigned total_machines, double memory_threshold = 0.9);
+   void Subscribe(ChangeListener * listener)  { listeners.push_back(listener); }
+
+   // Re-reads the machine and publishes whatever changed since the last look
+   void Refresh(Time_t now, MachineId_t machine_id);
+   // Same for a VM whose task set changed; also refreshes its machine
+   void RefreshVM(Time_t now, VMId_t vm_id, MachineId_t machine_id);
+
+   struct MachineSnapshot {
+      unsigned active_tasks = 0;
+      unsigned num_cpus = 0;
+      unsigned memory_used = 0;
+      MachineState_t s_state = S5;             // so machines that start awake are reported
+      CPUPerformance_t p_state = P0;
+      bool idle = false;
+      bool above_threshold = false;
+   };
+
+   bool IsIdle(MachineId_t machine_id) const  { return snapshots[machine_id].idle; }
+   // The machine as of its last Refresh()
+   const MachineSnapshot & Snapshot(MachineId_t machine_id) const   { return snapshots[machine_id]; }
+private:
+   vector<MachineSnapshot> snapshots;
+   vector<unsigned> vm_tasks;                  // indexed by VMId_t, grows on demand
+   vector<ChangeListener *> listeners;
+   double memory_threshold = 0.9;
+};
+
+
+#endif /* ChangeFeed_hpp */
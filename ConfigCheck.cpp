@@ -0,0 +1,58 @@
+//
+//  ConfigCheck.cpp
+//  CloudSim
+//
+//  Usage: configcheck [-r repeats] input_file...
+//  Parses and validates simulator input files without running them. Prints
+//  a summary of each file and its warnings, or the first error with its line
+//  and column, and exits with 1 if any file has an error. With -r every file
+//  is parsed `repeats` times and the fastest parse is reported.
+//
+
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include "ConfigParser.hpp"
+
+
+int main(int argc, char * argv[]) {
+   unsigned repeats = 1;
+   int first = 1;
+   if (argc > 2 && string(argv[1]) == "-r") {
+      repeats = max(unsigned(strtoul(argv[2], nullptr, 10)), 1u);
+      first = 3;
+   }
+   if (first >= argc) {
+      cerr << "Usage: " << argv[0] << " [-r repeats] input_file..." << endl;
+      return 2;
+   }
+
+   int status = 0;
+   for (int i = first; i < argc; i++) {
+      try {
+         SimulatorConfig config;
+         double best = 0;
+         for (unsigned r = 0; r < repeats; r++) {
+            config = SimulatorConfig();
+            auto start = chrono::steady_clock::now();
+            ParseConfigFile(argv[i], config);
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            best = r == 0 ? seconds : min(best, seconds);
+         }
+
+         for (const string & warning : config.warnings) cerr << warning << endl;
+         cout << argv[i] << ": " << config.machine_classes.size() << " machine classes (" << config.TotalMachines()
+              << " machines), " << config.task_classes.size() << " task classes, " << config.rack_classes.size()
+              << " rack classes; " << fixed << setprecision(2) << config.bytes / 1e6 << " MB in " << setprecision(3)
+              << best * 1e3 << " ms (" << setprecision(0) << config.bytes / 1e6 / max(best, 1e-9) << " MB/s)" << endl;
+         cout.unsetf(ios::floatfield);
+      } catch (const exception & e) {
+         cerr << e.what() << endl;
+         status = 1;
+      }
+   }
+   return status;
+}
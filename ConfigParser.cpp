@@ -0,0 +1,520 @@
+//
+//  ConfigParser.cpp
+//  CloudSim
+//
+
+
+#include "ConfigParser.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+
+typedef enum {
+   NUMBER,                     // unsigned
+   WIDE_NUMBER,                // uint64_t: times and seeds
+   ARRAY,                      // `size` unsigned values in brackets
+   CPU_NAME,
+   VM_NAME,
+   SLA_NAME,
+   TASK_NAME,
+   YES_NO
+} ValueKind_t;
+
+struct Key {
+   const char * name;
+   ValueKind_t kind;
+   unsigned size;              // values in an ARRAY
+   bool optional;
+};
+
+struct Name {
+   const char * name;
+   unsigned value;
+};
+
+const Key MACHINE_KEYS[] = {
+   {"Number of machines", NUMBER, 1, false},
+   {"CPU type", CPU_NAME, 1, false},
+   {"Number of cores", NUMBER, 1, false},
+   {"Memory", NUMBER, 1, false},
+   {"S-States", ARRAY, S_STATES, false},
+   {"P-States", ARRAY, P_STATES, false},
+   {"C-States", ARRAY, C_STATES, false},
+   {"MIPS", ARRAY, P_STATES, false},
+   {"GPUs", YES_NO, 1, false},
+};
+enum { M_MACHINES, M_CPU, M_CORES, M_MEMORY, M_S_STATES, M_P_STATES, M_C_STATES, M_MIPS, M_GPUS };
+
+const Key TASK_KEYS[] = {
+   {"Start time", WIDE_NUMBER, 1, false},
+   {"End time", WIDE_NUMBER, 1, false},
+   {"Inter arrival", WIDE_NUMBER, 1, false},
+   {"Expected runtime", WIDE_NUMBER, 1, false},
+   {"Memory", NUMBER, 1, false},
+   {"VM type", VM_NAME, 1, false},
+   {"GPU enabled", YES_NO, 1, false},
+   {"SLA type", SLA_NAME, 1, false},
+   {"CPU type", CPU_NAME, 1, false},
+   {"Task type", TASK_NAME, 1, false},
+   {"Seed", WIDE_NUMBER, 1, false},
+};
+enum { T_START, T_END, T_INTER_ARRIVAL, T_RUNTIME, T_MEMORY, T_VM, T_GPU, T_SLA, T_CPU, T_TASK, T_SEED };
+
+const Key RACK_KEYS[] = {
+   {"Number of racks", NUMBER, 1, false},
+   {"Machines per rack", NUMBER, 1, false},
+   {"Static power", NUMBER, 1, true},
+};
+enum { R_RACKS, R_PER_RACK, R_STATIC_POWER };
+
+const unsigned MAX_KEYS = sizeof(TASK_KEYS) / sizeof(TASK_KEYS[0]);
+
+// The names Init's MapNameToType accepts
+const Name CPU_NAMES[] = {{"ARM", ARM}, {"POWER", POWER}, {"RISCV", RISCV}, {"X86", X86}};
+const Name VM_NAMES[] = {{"LINUX", LINUX}, {"LINUX_RT", LINUX_RT}, {"WIN", WIN}, {"AIX", AIX}};
+const Name SLA_NAMES[] = {{"SLA0", SLA0}, {"SLA1", SLA1}, {"SLA2", SLA2}, {"SLA3", SLA3}};
+const Name TASK_NAMES[] = {{"AI", AI_TRAINING}, {"CRYPTO", CRYPTO}, {"HPC", SCIENTIFIC}, {"STREAM", STREAMING}, {"WEB", WEB_REQUEST}};
+const Name YES_NO_NAMES[] = {{"yes", 1}, {"no", 0}};
+
+typedef enum {
+   MACHINE_BLOCK,
+   TASK_BLOCK,
+   RACK_BLOCK
+} BlockKind_t;
+
+struct Block {
+   const char * header;        // as written, without the colon
+   const Key * keys;
+   unsigned num_keys;
+};
+
+const Block BLOCKS[] = {
+   {"machine class", MACHINE_KEYS, sizeof(MACHINE_KEYS) / sizeof(MACHINE_KEYS[0])},
+   {"task class", TASK_KEYS, sizeof(TASK_KEYS) / sizeof(TASK_KEYS[0])},
+   {"rack class", RACK_KEYS, sizeof(RACK_KEYS) / sizeof(RACK_KEYS[0])},
+};
+
+// A value read for one key of the block being parsed, with where it was found
+struct Value {
+   bool seen;
+   unsigned line;
+   unsigned column;
+   uint64_t v[S_STATES];
+};
+
+
+bool Matches(const char * begin, const char * end, const char * word) {
+   size_t length = strlen(word);
+   return size_t(end - begin) == length && memcmp(begin, word, length) == 0;
+}
+
+
+bool IsNameChar(char c) {
+   return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+
+class Parser {
+public:
+   Parser(const char * text, size_t size, const string & source, SimulatorConfig & config)
+      : p(text), end(text + size), line_start(text), source(source), config(config) {}
+   void Parse();
+private:
+   const char * p;
+   const char * end;
+   const char * line_start;
+   unsigned line = 1;
+   const string & source;
+   SimulatorConfig & config;
+
+   Value values[MAX_KEYS];
+   unsigned block_line = 0;
+
+   unsigned Column(const char * at) const   { return unsigned(at - line_start) + 1; }
+   [[noreturn]] void Fail(unsigned at_line, unsigned at_column, const string & message) const {
+      throw ConfigError(source, at_line, at_column, message);
+   }
+   [[noreturn]] void Fail(const char * at, const string & message) const   { Fail(line, Column(at), message); }
+   [[noreturn]] void Fail(const Value & value, const string & message) const   { Fail(value.line, value.column, message); }
+   void Warn(unsigned at_line, const string & message) {
+      config.warnings.push_back(source + ":" + to_string(at_line) + ":1: warning: " + message);
+   }
+
+   void SkipBlank();
+   void SkipSpaces();
+   void EndOfLine();
+   const char * Label(const char * & label_end);
+   void ParseBlock(BlockKind_t kind);
+   void ParseValue(const Key & key, Value & value);
+   uint64_t ParseNumber(const Key & key, uint64_t max);
+   unsigned ParseName(const Key & key);
+
+   void FinishMachine();
+   void FinishTask();
+   void FinishRack();
+   void CrossCheck();
+};
+
+
+void Parser::Parse() {
+   config.bytes += size_t(end - p);
+   for (;;) {
+      SkipBlank();
+      if (p == end) break;
+      const char * header = p;
+      const char * header_end;
+      Label(header_end);
+      unsigned kind = 0;
+      while (kind < sizeof(BLOCKS) / sizeof(BLOCKS[0]) && !Matches(header, header_end, BLOCKS[kind].header)) kind++;
+      if (kind == sizeof(BLOCKS) / sizeof(BLOCKS[0])) {
+         Fail(header, "Expected 'machine class:', 'task class:' or 'rack class:' but found '" + string(header, header_end) + "'");
+      }
+      ParseBlock(BlockKind_t(kind));
+   }
+   CrossCheck();
+}
+
+
+// Spaces, line ends and comments
+void Parser::SkipBlank() {
+   while (p < end) {
+      char c = *p;
+      if (c == '\n') {
+         line++;
+         line_start = ++p;
+      } else if (c == ' ' || c == '\t' || c == '\r') {
+         p++;
+      } else if (c == '#') {
+         const char * newline = static_cast<const char *>(memchr(p, '\n', size_t(end - p)));
+         p = newline == nullptr ? end : newline;
+      } else {
+         break;
+      }
+   }
+}
+
+
+void Parser::SkipSpaces() {
+   while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+}
+
+
+// Only a comment may follow on the line
+void Parser::EndOfLine() {
+   SkipSpaces();
+   if (p < end && *p == '#') {
+      const char * newline = static_cast<const char *>(memchr(p, '\n', size_t(end - p)));
+      p = newline == nullptr ? end : newline;
+   }
+   if (p == end) return;
+   if (*p != '\n') Fail(p, "Unexpected '" + string(p, find(p, end, '\n')) + "' at the end of the line");
+   line++;
+   line_start = ++p;
+}
+
+
+// Reads `label:` up to the colon, leaving p after it; the label has no trailing blanks
+const char * Parser::Label(const char * & label_end) {
+   const char * begin = p;
+   while (p < end && *p != ':' && *p != '\n' && *p != '#') p++;
+   if (p == end || *p != ':') {
+      Fail(begin, "Expected 'keyword: value' but found '" + string(begin, p) + "'");
+   }
+   label_end = p++;
+   while (label_end > begin && (label_end[-1] == ' ' || label_end[-1] == '\t')) label_end--;
+   return begin;
+}
+
+
+void Parser::ParseBlock(BlockKind_t kind) {
+   const Block & block = BLOCKS[kind];
+   block_line = line;
+   EndOfLine();
+   SkipBlank();
+   if (p == end || *p != '{') {
+      Fail(p, string("Expected { after ") + block.header + ":");
+   }
+   p++;
+   EndOfLine();
+
+   for (unsigned k = 0; k < block.num_keys; k++) values[k].seen = false;
+   for (;;) {
+      SkipBlank();
+      if (p == end) {
+         Fail(block_line, 1, string("Missing } at the end of the ") + block.header);
+      }
+      if (*p == '}') {
+         p++;
+         EndOfLine();
+         break;
+      }
+      const char * key_end;
+      const char * key_begin = Label(key_end);
+      unsigned k = 0;
+      while (k < block.num_keys && !Matches(key_begin, key_end, block.keys[k].name)) k++;
+      if (k == block.num_keys) {
+         Fail(key_begin, "Unknown " + string(block.header) + " key '" + string(key_begin, key_end) + "'");
+      }
+      if (values[k].seen) {
+         Fail(key_begin, string(block.keys[k].name) + " is given twice; first on line " + to_string(values[k].line));
+      }
+      SkipSpaces();
+      values[k].seen = true;
+      values[k].line = line;
+      values[k].column = Column(p);
+      ParseValue(block.keys[k], values[k]);
+      EndOfLine();
+   }
+
+   for (unsigned k = 0; k < block.num_keys; k++) {
+      if (!values[k].seen && !block.keys[k].optional) {
+         Fail(block_line, 1, string("The ") + block.header + " is missing '" + block.keys[k].name + "'");
+      }
+   }
+   if (kind == MACHINE_BLOCK) FinishMachine();
+   else if (kind == TASK_BLOCK) FinishTask();
+   else FinishRack();
+}
+
+
+void Parser::ParseValue(const Key & key, Value & value) {
+   switch (key.kind) {
+      case NUMBER:
+         value.v[0] = ParseNumber(key, UINT32_MAX);
+         break;
+      case WIDE_NUMBER:
+         value.v[0] = ParseNumber(key, UINT64_MAX);
+         break;
+      case ARRAY: {
+         const char * open = p;
+         if (p == end || *p != '[') Fail(p, string("Expected '[' at the start of ") + key.name);
+         p++;
+         unsigned count = 0;
+         SkipSpaces();
+         if (p < end && *p == ']') {
+            p++;
+         } else {
+            for (;;) {
+               SkipSpaces();
+               uint64_t number = ParseNumber(key, UINT32_MAX);
+               if (count < key.size) value.v[count] = number;
+               count++;
+               SkipSpaces();
+               if (p < end && *p == ',') {
+                  p++;
+               } else if (p < end && *p == ']') {
+                  p++;
+                  break;
+               } else {
+                  Fail(p, string("Expected ',' or ']' in ") + key.name);
+               }
+            }
+         }
+         if (count != key.size) {
+            Fail(open, string(key.name) + " needs " + to_string(key.size) + " values but has " + to_string(count));
+         }
+         break;
+      }
+      default:
+         value.v[0] = ParseName(key);
+         break;
+   }
+}
+
+
+uint64_t Parser::ParseNumber(const Key & key, uint64_t max) {
+   const char * begin = p;
+   if (p == end || *p < '0' || *p > '9') {
+      Fail(p, string("Expected a number for ") + key.name);
+   }
+   uint64_t number = 0;
+   for (; p < end && *p >= '0' && *p <= '9'; p++) {
+      unsigned digit = unsigned(*p - '0');
+      if (number > (max - digit) / 10) Fail(begin, string(key.name) + " is out of range");
+      number = number * 10 + digit;
+   }
+   if (p < end && (IsNameChar(*p) || *p == '.')) {
+      Fail(begin, string("Expected a whole number for ") + key.name);
+   }
+   return number;
+}
+
+
+unsigned Parser::ParseName(const Key & key) {
+   const Name * names;
+   size_t count;
+   switch (key.kind) {
+      case CPU_NAME:  names = CPU_NAMES;    count = sizeof(CPU_NAMES) / sizeof(Name);    break;
+      case VM_NAME:   names = VM_NAMES;     count = sizeof(VM_NAMES) / sizeof(Name);     break;
+      case SLA_NAME:  names = SLA_NAMES;    count = sizeof(SLA_NAMES) / sizeof(Name);    break;
+      case TASK_NAME: names = TASK_NAMES;   count = sizeof(TASK_NAMES) / sizeof(Name);   break;
+      default:        names = YES_NO_NAMES; count = sizeof(YES_NO_NAMES) / sizeof(Name); break;
+   }
+   const char * begin = p;
+   while (p < end && IsNameChar(*p)) p++;
+   for (size_t i = 0; i < count; i++) {
+      if (Matches(begin, p, names[i].name)) return names[i].value;
+   }
+
+   string expected = names[0].name;
+   for (size_t i = 1; i < count; i++) {
+      expected += (i + 1 == count ? " or " : ", ") + string(names[i].name);
+   }
+   Fail(begin, "Unknown " + string(key.name) + " '" + string(begin, find(begin, end, '\n')) + "', expected " + expected);
+}
+
+
+void Parser::FinishMachine() {
+   MachineClassSpec spec;
+   spec.line = block_line;
+   spec.machines = unsigned(values[M_MACHINES].v[0]);
+   spec.cpu = CPUType_t(values[M_CPU].v[0]);
+   spec.num_cpus = unsigned(values[M_CORES].v[0]);
+   spec.memory_size = unsigned(values[M_MEMORY].v[0]);
+   for (unsigned s = 0; s < S_STATES; s++) spec.s_states[s] = unsigned(values[M_S_STATES].v[s]);
+   for (unsigned c = 0; c < C_STATES; c++) spec.c_states[c] = unsigned(values[M_C_STATES].v[c]);
+   for (unsigned q = 0; q < P_STATES; q++) {
+      spec.p_states[q] = unsigned(values[M_P_STATES].v[q]);
+      spec.mips[q] = unsigned(values[M_MIPS].v[q]);
+      if (spec.mips[q] == 0) Fail(values[M_MIPS], "MIPS must be positive in every P-state");
+   }
+   spec.gpus = values[M_GPUS].v[0] != 0;
+
+   if (spec.num_cpus == 0) Fail(values[M_CORES], "Number of cores must be at least 1");
+   if (spec.memory_size == 0) Fail(values[M_MEMORY], "Memory must be positive");
+   if (spec.machines == 0) Warn(block_line, "The machine class has no machines");
+   for (unsigned q = 1; q < P_STATES; q++) {
+      if (spec.mips[q] > spec.mips[q - 1]) {
+         Warn(values[M_MIPS].line, "MIPS grows from P" + to_string(q - 1) + " to P" + to_string(q));
+         break;
+      }
+   }
+   config.machine_classes.push_back(spec);
+}
+
+
+void Parser::FinishTask() {
+   TaskClassSpec spec;
+   spec.line = block_line;
+   spec.start = values[T_START].v[0];
+   spec.end = values[T_END].v[0];
+   spec.inter_arrival = values[T_INTER_ARRIVAL].v[0];
+   spec.expected_runtime = values[T_RUNTIME].v[0];
+   spec.memory = unsigned(values[T_MEMORY].v[0]);
+   spec.vm_type = VMType_t(values[T_VM].v[0]);
+   spec.gpu_enabled = values[T_GPU].v[0] != 0;
+   spec.sla = SLAType_t(values[T_SLA].v[0]);
+   spec.cpu = CPUType_t(values[T_CPU].v[0]);
+   spec.task_class = TaskClass_t(values[T_TASK].v[0]);
+   spec.seed = values[T_SEED].v[0];
+
+   if (spec.end < spec.start) Fail(values[T_END], "End time comes before Start time");
+   if (spec.inter_arrival == 0) Fail(values[T_INTER_ARRIVAL], "Inter arrival must be at least 1 us");
+   if (spec.expected_runtime == 0) Fail(values[T_RUNTIME], "Expected runtime must be at least 1 us");
+   config.task_classes.push_back(spec);
+}
+
+
+void Parser::FinishRack() {
+   RackClassSpec spec;
+   spec.line = block_line;
+   spec.racks = unsigned(values[R_RACKS].v[0]);
+   spec.machines_per_rack = unsigned(values[R_PER_RACK].v[0]);
+   spec.static_power = values[R_STATIC_POWER].seen ? unsigned(values[R_STATIC_POWER].v[0]) : 0;
+
+   if (spec.racks == 0) Fail(values[R_RACKS], "Number of racks must be at least 1");
+   if (spec.machines_per_rack == 0) Fail(values[R_PER_RACK], "Machines per rack must be at least 1");
+   config.rack_classes.push_back(spec);
+}
+
+
+// Checks across blocks; only worth a warning because the simulator runs regardless
+void Parser::CrossCheck() {
+   const vector<MachineClassSpec> & machines = config.machine_classes;
+   if (machines.empty()) return;
+
+   // Largest machine of each CPU type, 0 when there is none
+   unsigned largest_memory[X86 + 1] = {};
+   for (const MachineClassSpec & machine : machines) {
+      if (machine.machines > 0) largest_memory[machine.cpu] = max(largest_memory[machine.cpu], machine.memory_size);
+   }
+   for (const TaskClassSpec & task : config.task_classes) {
+      unsigned largest = largest_memory[task.cpu];
+      if (largest == 0) {
+         Warn(task.line, "No machine has the CPU type of this task class");
+      } else if (uint64_t(task.memory) + VM_MEMORY_OVERHEAD > largest) {
+         Warn(task.line, "Tasks need " + to_string(task.memory) + " MB but the largest machine of their CPU type has " +
+                         to_string(largest) + " MB");
+      }
+   }
+
+   if (!config.rack_classes.empty()) {
+      uint64_t in_racks = 0;
+      for (const RackClassSpec & rack : config.rack_classes) in_racks += uint64_t(rack.racks) * rack.machines_per_rack;
+      if (in_racks < config.TotalMachines()) {
+         Warn(config.rack_classes.front().line, "The racks hold " + to_string(in_racks) + " of the " +
+                                                to_string(config.TotalMachines()) + " machines");
+      }
+   }
+}
+
+
+// Read-only mapping of the input, released even when parsing throws
+class MappedFile {
+public:
+   explicit MappedFile(const string & filename) {
+      int fd = open(filename.c_str(), O_RDONLY);
+      if (fd < 0) throw runtime_error("ParseConfigFile(): Could not open " + filename);
+      struct stat st;
+      if (fstat(fd, &st) != 0) {
+         close(fd);
+         throw runtime_error("ParseConfigFile(): Could not read " + filename);
+      }
+      size = size_t(st.st_size);
+      if (size > 0) {
+         base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+         if (base == MAP_FAILED) {
+            close(fd);
+            throw runtime_error("ParseConfigFile(): Could not map " + filename);
+         }
+         madvise(base, size, MADV_SEQUENTIAL);
+      }
+      close(fd);
+   }
+   ~MappedFile()               { if (size > 0) munmap(base, size); }
+   MappedFile(const MappedFile &) = delete;
+   MappedFile & operator=(const MappedFile &) = delete;
+
+   const char * Text() const   { return static_cast<const char *>(base); }
+   size_t Size() const         { return size; }
+private:
+   void * base = nullptr;
+   size_t size = 0;
+};
+
+}
+
+
+unsigned SimulatorConfig::TotalMachines() const {
+   unsigned total = 0;
+   for (const MachineClassSpec & machine_class : machine_classes) total += machine_class.machines;
+   return total;
+}
+
+
+void ParseConfigFile(const string & filename, SimulatorConfig & config) {
+   MappedFile file(filename);
+   ParseConfig(file.Text(), file.Size(), filename, config);
+}
+
+
+void ParseConfig(const char * text, size_t size, const string & source, SimulatorConfig & config) {
+   Parser(text, size, source, config).Parse();
+}
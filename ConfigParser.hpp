@@ -0,0 +1,95 @@
+//
+//  ConfigParser.hpp
+//  CloudSim
+//
+//  Parser and validator for simulator input files: `machine class:`,
+//  `task class:` and `rack class:` blocks. The file is memory-mapped and read
+//  in a single pass; keys, names and numbers are matched in place without
+//  copying them into strings. Errors are thrown as ConfigError with the line
+//  and column of the offending token, and every block is checked against the
+//  simulator's model: all keys present and none repeated, S-, P- and C-state
+//  and MIPS arrays of S_STATES, P_STATES and C_STATES values, known type
+//  names, and sensible numbers. Problems that the simulator survives but that
+//  are probably mistakes (a task class no machine can run) are collected as
+//  warnings instead.
+//
+
+
+#ifndef ConfigParser_hpp
+#define ConfigParser_hpp
+
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "SimTypes.h"
+
+
+class ConfigError : public runtime_error {
+public:
+   ConfigError(const string & source, unsigned line, unsigned column, const string & message)
+      : runtime_error(source + ":" + to_string(line) + ":" + to_string(column) + ": " + message), line(line), column(column) {}
+
+   unsigned line;
+   unsigned column;
+};
+
+
+struct MachineClassSpec {
+   unsigned line;                      // of the `machine class:` header
+   unsigned machines;
+   CPUType_t cpu;
+   unsigned num_cpus;
+   unsigned memory_size;
+   unsigned s_states[S_STATES];
+   unsigned p_states[P_STATES];
+   unsigned c_states[C_STATES];
+   unsigned mips[P_STATES];
+   bool gpus;
+};
+
+
+struct TaskClassSpec {
+   unsigned line;                      // of the `task class:` header
+   Time_t start;
+   Time_t end;
+   Time_t inter_arrival;
+   Time_t expected_runtime;
+   unsigned memory;
+   VMType_t vm_type;
+   bool gpu_enabled;
+   SLAType_t sla;
+   CPUType_t cpu;
+   TaskClass_t task_class;
+   uint64_t seed;
+};
+
+
+struct RackClassSpec {
+   unsigned line;                      // of the `rack class:` header
+   unsigned racks;
+   unsigned machines_per_rack;
+   unsigned static_power;              // W, 0 when not given
+};
+
+
+struct SimulatorConfig {
+   vector<MachineClassSpec> machine_classes;
+   vector<TaskClassSpec> task_classes;
+   vector<RackClassSpec> rack_classes;
+   vector<string> warnings;            // "source:line:column: warning: message"
+   size_t bytes = 0;                   // size of the parsed input
+
+   unsigned TotalMachines() const;
+};
+
+
+// Both throw ConfigError on the first syntax or semantic error; `source` names the input in messages.
+// ParseConfigFile throws runtime_error if the file cannot be read.
+void ParseConfigFile(const string & filename, SimulatorConfig & config);
+void ParseConfig(const char * text, size_t size, const string & source, SimulatorConfig & config);
+
+
+#endif /* ConfigParser_hpp */
@@ -0,0 +1,132 @@
+//
+//  DecisionDiff.cpp
+//  CloudSim
+//
+//  Usage: decisiondiff [-c context] old.log new.log
+//         decisiondiff -p log
+//  Compares two decision logs (CLOUDSIM_DECISIONS) record by record and stops
+//  at the first one that differs, printing it with the records leading up to
+//  it. Exits with 0 if the logs are identical, 1 if they diverge, 2 on error.
+//  With -p a single log is printed.
+//
+
+
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "DecisionLog.hpp"
+
+
+using namespace std;
+
+
+// Read-only view of a log file, mapped rather than read so large logs cost nothing up front
+class MappedLog {
+public:
+   explicit MappedLog(const string & filename) {
+      int fd = open(filename.c_str(), O_RDONLY);
+      if (fd < 0) throw runtime_error("decisiondiff: Cannot open " + filename);
+      struct stat st;
+      fstat(fd, &st);
+      size = size_t(st.st_size);
+      if (size < sizeof(DecisionLogHeader)) {
+         close(fd);
+         throw runtime_error("decisiondiff: " + filename + " is not a decision log");
+      }
+      base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      close(fd);
+      if (base == MAP_FAILED) throw runtime_error("decisiondiff: Cannot map " + filename);
+
+      const DecisionLogHeader * header = static_cast<const DecisionLogHeader *>(base);
+      if (memcmp(header->magic, DECISION_LOG_MAGIC, sizeof(DECISION_LOG_MAGIC)) != 0 ||
+          header->record_size != sizeof(DecisionRecord)) {
+         munmap(base, size);
+         throw runtime_error("decisiondiff: " + filename + " is not a decision log of this version");
+      }
+      records = reinterpret_cast<const DecisionRecord *>(static_cast<const char *>(base) + sizeof(DecisionLogHeader));
+      count = (size - sizeof(DecisionLogHeader)) / sizeof(DecisionRecord);
+   }
+   ~MappedLog()                { munmap(base, size); }
+   MappedLog(const MappedLog &) = delete;
+   MappedLog & operator=(const MappedLog &) = delete;
+
+   const DecisionRecord * records;
+   uint64_t count;
+private:
+   void * base;
+   size_t size;
+};
+
+
+static bool Same(const DecisionRecord & x, const DecisionRecord & y) {
+   return x.time == y.time && x.kind == y.kind && x.a == y.a && x.b == y.b && x.c == y.c;
+}
+
+
+static void Print(const char * tag, uint64_t index, const DecisionRecord & record) {
+   cout << tag << " #" << index << " t=" << record.time << " " << FormatDecision(record) << "\n";
+}
+
+
+int main(int argc, char * argv[]) {
+   uint64_t context = 5;
+   bool print_only = false;
+   int opt;
+   while ((opt = getopt(argc, argv, "c:p")) != -1) {
+      switch (opt) {
+         case 'c': context = strtoull(optarg, nullptr, 10); break;
+         case 'p': print_only = true; break;
+         default:
+            cerr << "Usage: " << argv[0] << " [-c context] old.log new.log | -p log" << endl;
+            return 2;
+      }
+   }
+   if (argc - optind != (print_only ? 1 : 2)) {
+      cerr << "Usage: " << argv[0] << " [-c context] old.log new.log | -p log" << endl;
+      return 2;
+   }
+
+   try {
+      if (print_only) {
+         MappedLog log(argv[optind]);
+         for (uint64_t i = 0; i < log.count; i++) {
+            Print(" ", i, log.records[i]);
+         }
+         return 0;
+      }
+
+      MappedLog old_log(argv[optind]);
+      MappedLog new_log(argv[optind + 1]);
+      uint64_t common = min(old_log.count, new_log.count);
+      uint64_t i = 0;
+      while (i < common && Same(old_log.records[i], new_log.records[i])) i++;
+
+      if (i == old_log.count && i == new_log.count) {
+         cout << "Identical: " << i << " decisions" << endl;
+         return 0;
+      }
+
+      cout << "First divergence after " << i << " identical decisions";
+      if (i < common) {
+         cout << ", at time " << min(old_log.records[i].time, new_log.records[i].time);
+      }
+      cout << "\n";
+      for (uint64_t k = i - min(i, context); k < i; k++) {
+         Print(" ", k, old_log.records[k]);
+      }
+      if (i < old_log.count) Print("-", i, old_log.records[i]);
+      else cout << "- (end of " << argv[optind] << ")\n";
+      if (i < new_log.count) Print("+", i, new_log.records[i]);
+      else cout << "+ (end of " << argv[optind + 1] << ")\n";
+      cout.flush();
+      return 1;
+   } catch (const exception & e) {
+      cerr << e.what() << endl;
+      return 2;
+   }
+}
@@ -0,0 +1,62 @@
+//
+//  DecisionLog.cpp
+//  CloudSim
+//
+
+
+#include "DecisionLog.hpp"
+
+#include <cstring>
+
+#include "Interfaces.h"
+
+
+void DecisionLog::Open(const string & filename) {
+   Close();
+   file = fopen(filename.c_str(), "wb");
+   if (file == nullptr) {
+      ThrowException("DecisionLog::Open(): Could not create ", filename);
+   }
+   DecisionLogHeader header = {};
+   memcpy(header.magic, DECISION_LOG_MAGIC, sizeof(DECISION_LOG_MAGIC));
+   header.record_size = sizeof(DecisionRecord);
+   fwrite(&header, sizeof(header), 1, file);
+   buffer.reserve(BUFFER_RECORDS);
+   written = 0;
+}
+
+
+void DecisionLog::Flush() {
+   if (!buffer.empty() && fwrite(buffer.data(), sizeof(DecisionRecord), buffer.size(), file) != buffer.size()) {
+      ThrowException("DecisionLog::Flush(): Write failed after records: ", unsigned(written));
+   }
+   written += buffer.size();
+   buffer.clear();
+}
+
+
+// A destructor must not throw, so a log that was never closed reports a failure instead
+DecisionLog::~DecisionLog() {
+   if (!Finish()) {
+      SimOutput("DecisionLog::~DecisionLog(): Write failed after records: " + to_string(written), 0);
+   }
+}
+
+
+void DecisionLog::Close() {
+   if (!Finish()) {
+      ThrowException("DecisionLog::Close(): Write failed after records: ", unsigned(written));
+   }
+}
+
+
+// Writes the buffered records and closes the file. False if either failed.
+bool DecisionLog::Finish() {
+   if (file == nullptr) return true;
+   bool ok = buffer.empty() || fwrite(buffer.data(), sizeof(DecisionRecord), buffer.size(), file) == buffer.size();
+   if (ok) written += buffer.size();
+   buffer.clear();
+   ok = fclose(file) == 0 && ok;
+   file = nullptr;
+   return ok;
+}
@@ -0,0 +1,115 @@
+//
+//  DecisionLog.hpp
+//  CloudSim
+//
+//  Binary log of every action the scheduler takes on the cluster (VM
+//  creation, attachment, task placement, migration, shutdown, machine state,
+//  core performance and task priority changes), stamped with the simulated
+//  time. Records are fixed-size and appended to an in-memory buffer that is
+//  written out in large blocks, so logging costs a few stores per action.
+//  Two logs of the same input can be compared with `decisiondiff`, which
+//  stops at the first decision that differs.
+//
+//  File layout: a DecisionLogHeader, then DecisionRecords until the end.
+//
+
+
+#ifndef DecisionLog_hpp
+#define DecisionLog_hpp
+
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "SimTypes.h"
+
+
+typedef enum {
+   DECISION_VM_CREATE,                 // a: VM, b: VM type, c: CPU type
+   DECISION_VM_ATTACH,                 // a: VM, b: machine
+   DECISION_VM_ADD_TASK,               // a: VM, b: task, c: priority
+   DECISION_VM_MIGRATE,                // a: VM, b: destination machine
+   DECISION_VM_SHUTDOWN,               // a: VM
+   DECISION_MACHINE_SET_STATE,         // a: machine, b: S-state
+   DECISION_MACHINE_SET_CORE_PERFORMANCE,  // a: machine, b: core, c: P-state
+   DECISION_SET_TASK_PRIORITY,         // a: task, b: priority
+   NUM_DECISIONS
+} DecisionKind_t;
+
+
+struct DecisionRecord {
+   uint64_t time;
+   uint32_t kind;
+   uint32_t a;
+   uint32_t b;
+   uint32_t c;
+};
+static_assert(sizeof(DecisionRecord) == 24, "DecisionRecord is part of the file format");
+
+
+struct DecisionLogHeader {
+   char magic[8];                      // "CSDLOG1\0"
+   uint32_t record_size;
+   uint32_t reserved;
+};
+
+#define DECISION_LOG_MAGIC "CSDLOG1"
+
+
+inline const char * DecisionName(uint32_t kind) {
+   static const char * names[NUM_DECISIONS] = {
+      "VM_Create", "VM_Attach", "VM_AddTask", "VM_Migrate", "VM_Shutdown",
+      "Machine_SetState", "Machine_SetCorePerformance", "SetTaskPriority"
+   };
+   return kind < NUM_DECISIONS ? names[kind] : "unknown";
+}
+
+// One line such as "VM_AddTask vm 3 task 17 priority 1"
+inline std::string FormatDecision(const DecisionRecord & r) {
+   using std::to_string;
+   std::string name = DecisionName(r.kind);
+   switch (r.kind) {
+      case DECISION_VM_CREATE:     return name + " vm " + to_string(r.a) + " type " + to_string(r.b) + " cpu " + to_string(r.c);
+      case DECISION_VM_ATTACH:     return name + " vm " + to_string(r.a) + " machine " + to_string(r.b);
+      case DECISION_VM_ADD_TASK:   return name + " vm " + to_string(r.a) + " task " + to_string(r.b) + " priority " + to_string(r.c);
+      case DECISION_VM_MIGRATE:    return name + " vm " + to_string(r.a) + " to machine " + to_string(r.b);
+      case DECISION_VM_SHUTDOWN:   return name + " vm " + to_string(r.a);
+      case DECISION_MACHINE_SET_STATE: return name + " machine " + to_string(r.a) + " state " + to_string(r.b);
+      case DECISION_MACHINE_SET_CORE_PERFORMANCE:
+         return name + " machine " + to_string(r.a) + " core " + to_string(r.b) + " P-state " + to_string(r.c);
+      case DECISION_SET_TASK_PRIORITY: return name + " task " + to_string(r.a) + " priority " + to_string(r.b);
+      default:                     return name + " " + to_string(r.a) + " " + to_string(r.b) + " " + to_string(r.c);
+   }
+}
+
+
+class DecisionLog {
+public:
+   DecisionLog()               {}
+   ~DecisionLog();
+   // Starts a new log at `filename`, throws if it cannot be created
+   void Open(const std::string & filename);
+   // Writes the buffered records and closes the log; throws if that fails
+   void Close();
+   bool Enabled() const        { return file != nullptr; }
+
+   void Record(Time_t time, DecisionKind_t kind, unsigned a, unsigned b = 0, unsigned c = 0) {
+      if (file == nullptr) return;
+      buffer.push_back({time, uint32_t(kind), a, b, c});
+      if (buffer.size() == BUFFER_RECORDS) Flush();
+   }
+   uint64_t Records() const    { return written + buffer.size(); }
+private:
+   static const size_t BUFFER_RECORDS = 1 << 16;
+   FILE * file = nullptr;
+   std::vector<DecisionRecord> buffer;
+   uint64_t written = 0;
+
+   void Flush();
+   bool Finish();
+};
+
+
+#endif /* DecisionLog_hpp */
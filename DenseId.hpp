@@ -0,0 +1,220 @@
+//
+//  DenseId.hpp
+//  CloudSim
+//
+//  Containers keyed by the simulator's machine and VM ids. Both are handed
+//  out densely from 0, so they index arrays directly instead of being hashed:
+//     IdSet     membership bitset; iterates in ascending id order
+//     IdMap     id -> value array with an IdSet of the ids present
+//     IdLists   intrusive lists grouping ids under an owner (the VMs of each
+//               machine), which also answer the owner of an id
+//  Every container grows on demand, and lookups of ids they have never seen
+//  (including the -1 the interfaces use for "none") simply miss.
+//
+//  Containers are sized by the largest id they have seen and never shrink.
+//  Machine ids stay within the cluster's size. VM ids do not: a VM that
+//  VMPool retires keeps its id and the next one gets a new id, so VM-keyed
+//  containers grow with every VM created during the run, not with the VMs
+//  alive at once. Tasks are not kept here at all: the live task ids are a
+//  window sliding along the trace, so state kept per task is hashed on the
+//  live tasks only.
+//
+
+
+#ifndef DenseId_hpp
+#define DenseId_hpp
+
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+
+template <typename Id>
+class IdSet {
+public:
+   IdSet()                     {}
+
+   bool Contains(Id id) const {
+      size_t word = size_t(id) / 64;
+      return word < words.size() && (words[word] >> (size_t(id) % 64) & 1);
+   }
+   // False if the id was already in the set
+   bool Insert(Id id) {
+      size_t word = size_t(id) / 64;
+      if (word >= words.size()) words.resize(word + 1, 0);
+      uint64_t bit = uint64_t(1) << (size_t(id) % 64);
+      if (words[word] & bit) return false;
+      words[word] |= bit;
+      count++;
+      return true;
+   }
+   // False if the id was not in the set
+   bool Erase(Id id) {
+      if (!Contains(id)) return false;
+      words[size_t(id) / 64] &= ~(uint64_t(1) << (size_t(id) % 64));
+      count--;
+      return true;
+   }
+   void Clear() {
+      words.assign(words.size(), 0);
+      count = 0;
+   }
+   void Swap(IdSet & other) {
+      words.swap(other.words);
+      std::swap(count, other.count);
+   }
+   size_t Size() const         { return count; }
+   bool Empty() const          { return count == 0; }
+
+   class Iterator {
+   public:
+      Iterator(const std::vector<uint64_t> & words, size_t word) : words(words), word(word) {
+         bits = word < words.size() ? words[word] : 0;
+         Settle();
+      }
+      Id operator*() const     { return Id(word * 64 + size_t(__builtin_ctzll(bits))); }
+      Iterator & operator++() {
+         bits &= bits - 1;
+         Settle();
+         return *this;
+      }
+      bool operator!=(const Iterator & other) const   { return word != other.word || bits != other.bits; }
+   private:
+      const std::vector<uint64_t> & words;
+      size_t word;
+      uint64_t bits;           // ids of `word` not yet visited
+
+      void Settle() {
+         while (bits == 0 && word < words.size()) {
+            if (++word < words.size()) bits = words[word];
+         }
+      }
+   };
+   // The set must not change while it is being iterated
+   Iterator begin() const      { return Iterator(words, 0); }
+   Iterator end() const        { return Iterator(words, words.size()); }
+private:
+   std::vector<uint64_t> words;
+   size_t count = 0;
+};
+
+
+template <typename Id, typename Value>
+class IdMap {
+public:
+   IdMap()                     {}
+
+   bool Contains(Id id) const  { return present.Contains(id); }
+   // The id must be present
+   const Value & Get(Id id) const   { return values[size_t(id)]; }
+   Value & Get(Id id)               { return values[size_t(id)]; }
+   // Inserts a default value if the id is not present
+   Value & operator[](Id id) {
+      if (size_t(id) >= values.size()) values.resize(size_t(id) + 1);
+      if (present.Insert(id)) values[size_t(id)] = Value();
+      return values[size_t(id)];
+   }
+   void Set(Id id, const Value & value)   { (*this)[id] = value; }
+   bool Erase(Id id)           { return present.Erase(id); }
+   size_t Size() const         { return present.Size(); }
+   bool Empty() const          { return present.Empty(); }
+   // The ids present, in ascending order
+   const IdSet<Id> & Keys() const   { return present; }
+private:
+   std::vector<Value> values;
+   IdSet<Id> present;
+};
+
+
+template <typename Owner, typename Id>
+class IdLists {
+public:
+   IdLists()                   {}
+
+   // Appends the id to the owner's list, taking it off any list it was on
+   void Append(Owner owner, Id id) {
+      Unlink(id);
+      Grow(owner, id);
+      Node & node = nodes[size_t(id)];
+      node.owner = owner;
+      node.prev = lists[size_t(owner)].tail;
+      node.next = NONE;
+      if (node.prev != NONE) nodes[node.prev].next = uint32_t(id);
+      else lists[size_t(owner)].head = uint32_t(id);
+      lists[size_t(owner)].tail = uint32_t(id);
+      lists[size_t(owner)].size++;
+   }
+   // False if the id was not on a list
+   bool Remove(Id id)          { return Unlink(id); }
+
+   bool Contains(Id id) const  { return size_t(id) < nodes.size() && nodes[size_t(id)].owner != Owner(-1); }
+   // Owner(-1) if the id is not on a list
+   Owner OwnerOf(Id id) const  { return size_t(id) < nodes.size() ? nodes[size_t(id)].owner : Owner(-1); }
+   unsigned Count(Owner owner) const   { return size_t(owner) < lists.size() ? lists[size_t(owner)].size : 0; }
+
+   class Iterator {
+   public:
+      Iterator(const IdLists & lists, uint32_t current) : lists(lists), current(current) {
+         next = current != NONE ? lists.nodes[current].next : NONE;
+      }
+      Id operator*() const     { return Id(current); }
+      // The successor was read before the current id was handed out, so the
+      // current id may be removed or moved to another list during iteration
+      Iterator & operator++() {
+         current = next;
+         next = current != NONE ? lists.nodes[current].next : NONE;
+         return *this;
+      }
+      bool operator!=(const Iterator & other) const   { return current != other.current; }
+   private:
+      const IdLists & lists;
+      uint32_t current;
+      uint32_t next;
+   };
+   struct Range {
+      const IdLists & lists;
+      uint32_t head;
+      Iterator begin() const   { return Iterator(lists, head); }
+      Iterator end() const     { return Iterator(lists, NONE); }
+   };
+   // The ids of an owner, in the order they were appended
+   Range Of(Owner owner) const {
+      return {*this, size_t(owner) < lists.size() ? lists[size_t(owner)].head : NONE};
+   }
+private:
+   static const uint32_t NONE = uint32_t(-1);
+   struct Node {
+      Owner owner = Owner(-1);
+      uint32_t prev = NONE;
+      uint32_t next = NONE;
+   };
+   struct List {
+      uint32_t head = NONE;
+      uint32_t tail = NONE;
+      unsigned size = 0;
+   };
+   std::vector<Node> nodes;    // indexed by Id
+   std::vector<List> lists;    // indexed by Owner
+
+   void Grow(Owner owner, Id id) {
+      if (size_t(id) >= nodes.size()) nodes.resize(size_t(id) + 1);
+      if (size_t(owner) >= lists.size()) lists.resize(size_t(owner) + 1);
+   }
+   bool Unlink(Id id) {
+      if (!Contains(id)) return false;
+      Node & node = nodes[size_t(id)];
+      List & list = lists[size_t(node.owner)];
+      if (node.prev != NONE) nodes[node.prev].next = node.next;
+      else list.head = node.next;
+      if (node.next != NONE) nodes[node.next].prev = node.prev;
+      else list.tail = node.prev;
+      list.size--;
+      node = Node();
+      return true;
+   }
+};
+
+
+#endif /* DenseId_hpp */
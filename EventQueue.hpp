@@ -0,0 +1,164 @@
+//
+//  EventQueue.hpp
+//  CloudSim
+//
+//  Time-ordered event queue whose entries can be cancelled or moved. Push()
+//  returns a handle; Cancel() and Reschedule() take it and fix up the heap in
+//  O(log n), so an event that no longer applies (a completion that a P-state
+//  change or a migration moved) is removed right away instead of staying in
+//  the queue until it fires and is discarded. The heap is indexed: every
+//  event lives in a slot that knows its heap position, and handles carry the
+//  slot's generation so a handle to an event that already fired is rejected.
+//  Events with the same time fire in the order they were pushed.
+//
+
+
+#ifndef EventQueue_hpp
+#define EventQueue_hpp
+
+
+#include <cstdint>
+#include <vector>
+
+#include "SimTypes.h"
+
+
+typedef uint64_t EventHandle_t;
+#define INVALID_EVENT_HANDLE EventHandle_t(-1)
+
+
+template <typename Event>
+class EventQueue {
+public:
+   EventQueue()                {}
+
+   EventHandle_t Push(Time_t time, const Event & event) {
+      uint32_t slot;
+      if (free_slots.empty()) {
+         slot = uint32_t(slots.size());
+         slots.push_back(Slot());
+      } else {
+         slot = free_slots.back();
+         free_slots.pop_back();
+      }
+      slots[slot].event = event;
+      heap.push_back({time, sequence++, slot});
+      slots[slot].position = uint32_t(heap.size() - 1);
+      SiftUp(heap.size() - 1);
+      return Handle(slot);
+   }
+
+   // False if the event has already fired or been cancelled
+   bool Cancel(EventHandle_t handle) {
+      uint32_t slot;
+      if (!Live(handle, slot)) return false;
+      size_t position = slots[slot].position;
+      Release(slot);
+      Remove(position);
+      return true;
+   }
+
+   // Moves a pending event to `time`; false if it is no longer pending
+   bool Reschedule(EventHandle_t handle, Time_t time) {
+      uint32_t slot;
+      if (!Live(handle, slot)) return false;
+      size_t position = slots[slot].position;
+      Time_t before = heap[position].time;
+      heap[position].time = time;
+      heap[position].sequence = sequence++;
+      if (time < before) SiftUp(position);
+      else SiftDown(position);
+      return true;
+   }
+
+   bool Pending(EventHandle_t handle) const {
+      uint32_t slot;
+      return Live(handle, slot);
+   }
+
+   bool Empty() const          { return heap.empty(); }
+   size_t Size() const         { return heap.size(); }
+   Time_t NextTime() const     { return heap.front().time; }
+
+   // Removes the earliest event. The queue must not be empty.
+   Event Pop(Time_t & time) {
+      uint32_t slot = heap.front().slot;
+      time = heap.front().time;
+      Event event = slots[slot].event;
+      Release(slot);
+      Remove(0);
+      return event;
+   }
+private:
+   struct Entry {
+      Time_t time;
+      uint64_t sequence;
+      uint32_t slot;
+   };
+   struct Slot {
+      Event event;
+      uint32_t position = 0;
+      uint32_t generation = 0;             // odd while the slot holds a pending event
+   };
+   std::vector<Entry> heap;
+   std::vector<Slot> slots;
+   std::vector<uint32_t> free_slots;
+   uint64_t sequence = 0;
+
+   EventHandle_t Handle(uint32_t slot) {
+      Slot & s = slots[slot];
+      s.generation++;
+      return (EventHandle_t(s.generation) << 32) | slot;
+   }
+   bool Live(EventHandle_t handle, uint32_t & slot) const {
+      slot = uint32_t(handle);
+      return handle != INVALID_EVENT_HANDLE && slot < slots.size() && slots[slot].generation == uint32_t(handle >> 32) &&
+             (slots[slot].generation & 1);
+   }
+   void Release(uint32_t slot) {
+      slots[slot].generation++;
+      free_slots.push_back(slot);
+   }
+
+   static bool Before(const Entry & a, const Entry & b) {
+      return a.time != b.time ? a.time < b.time : a.sequence < b.sequence;
+   }
+   void Place(size_t position, const Entry & entry) {
+      heap[position] = entry;
+      slots[entry.slot].position = uint32_t(position);
+   }
+   void Remove(size_t position) {
+      Entry last = heap.back();
+      heap.pop_back();
+      if (position == heap.size()) return;
+      Place(position, last);
+      if (position > 0 && Before(heap[position], heap[(position - 1) / 2])) SiftUp(position);
+      else SiftDown(position);
+   }
+   void SiftUp(size_t position) {
+      Entry entry = heap[position];
+      while (position > 0) {
+         size_t parent = (position - 1) / 2;
+         if (!Before(entry, heap[parent])) break;
+         Place(position, heap[parent]);
+         position = parent;
+      }
+      Place(position, entry);
+   }
+   void SiftDown(size_t position) {
+      Entry entry = heap[position];
+      size_t size = heap.size();
+      for (;;) {
+         size_t child = 2 * position + 1;
+         if (child >= size) break;
+         if (child + 1 < size && Before(heap[child + 1], heap[child])) child++;
+         if (!Before(heap[child], entry)) break;
+         Place(position, heap[child]);
+         position = child;
+      }
+      Place(position, entry);
+   }
+};
+
+
+#endif /* EventQueue_hpp */
@@ -0,0 +1,69 @@
+//
+//  FreeMemoryIndex.cpp
+//  CloudSim
+//
+
+
+#include "FreeMemoryIndex.hpp"
+
+
+void FreeMemoryIndex::Init(unsigned total_machines) {
+   free_memory.assign(total_machines, 0);
+   indexed.assign(total_machines, false);
+   reserved.assign(total_machines, 0);
+   cpu_of.resize(total_machines);
+   for (unsigned i = 0; i < total_machines; i++) {
+      cpu_of[i] = Machine_GetCPUType(MachineId_t(i));
+      Update(MachineId_t(i));
+   }
+}
+
+
+void FreeMemoryIndex::Update(MachineId_t machine_id) {
+   Remove(machine_id);
+
+   MachineInfo_t m_info = Machine_GetInfo(machine_id);
+   if (m_info.s_state != S0) return;
+
+   // An overcommitted machine has no headroom at all, nor is memory promised to migrations free
+   unsigned used = m_info.memory_used + reserved[machine_id];
+   unsigned available = used < m_info.memory_size ? m_info.memory_size - used : 0;
+   free_memory[machine_id] = available;
+   indexed[machine_id] = true;
+   by_free[cpu_of[machine_id]].insert({available, machine_id});
+}
+
+
+void FreeMemoryIndex::Remove(MachineId_t machine_id) {
+   if (!indexed[machine_id]) return;
+   by_free[cpu_of[machine_id]].erase({free_memory[machine_id], machine_id});
+   indexed[machine_id] = false;
+}
+
+
+void FreeMemoryIndex::Reserve(MachineId_t machine_id, VMId_t vm_id, unsigned amount) {
+   Arrived(vm_id);
+   reservations[vm_id] = {machine_id, amount};
+   reserved[machine_id] += amount;
+   Update(machine_id);
+}
+
+
+void FreeMemoryIndex::Arrived(VMId_t vm_id) {
+   if (!reservations.Contains(vm_id)) return;
+   const Reservation & reservation = reservations.Get(vm_id);
+   reserved[reservation.machine_id] -= reservation.amount;
+   reservations.Erase(vm_id);
+}
+
+
+bool FreeMemoryIndex::FindHost(CPUType_t cpu, unsigned needed, MachineId_t exclude, const IdSet<MachineId_t> & powered_on,
+                               MachineId_t & host) const {
+   const auto & hosts = by_free[cpu];
+   for (auto it = hosts.lower_bound({needed, 0}); it != hosts.end(); it++) {
+      if (it->second == exclude || !powered_on.Contains(it->second)) continue;
+      host = it->second;
+      return true;
+   }
+   return false;
+}
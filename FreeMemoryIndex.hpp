@@ -0,0 +1,65 @@
+//
+//  FreeMemoryIndex.hpp
+//  CloudSim
+//
+//  Incremental index of the free memory on every powered-on machine, split by
+//  CPU type. Callers refresh a machine after they change it; lookups of a host
+//  with enough headroom are then logarithmic instead of a scan of the cluster.
+//  Memory promised to in-flight migrations is kept apart from what the
+//  simulator reports, so refreshing a destination does not hand it out again.
+//
+
+
+#ifndef FreeMemoryIndex_hpp
+#define FreeMemoryIndex_hpp
+
+
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "DenseId.hpp"
+#include "Interfaces.h"
+
+
+#define NUM_CPU_TYPES 4
+
+
+class FreeMemoryIndex {
+public:
+   FreeMemoryIndex()           {}
+   void Init(unsigned total_machines);
+
+   // Re-reads the machine and re-files it. Machines that are not in S0 are dropped.
+   void Update(MachineId_t machine_id);
+   void Remove(MachineId_t machine_id);
+   // Holds back memory on the machine for a VM migrating to it, until Arrived()
+   void Reserve(MachineId_t machine_id, VMId_t vm_id, unsigned amount);
+   // The VM's migration completed; the simulator now charges its memory to the host
+   void Arrived(VMId_t vm_id);
+
+   // Machine of the given CPU type with the least free memory that still fits
+   // `needed`, skipping `exclude` and machines outside `powered_on` (one on its
+   // way down still reports S0). Returns false when no host qualifies.
+   bool FindHost(CPUType_t cpu, unsigned needed, MachineId_t exclude, const IdSet<MachineId_t> & powered_on,
+                 MachineId_t & host) const;
+
+   unsigned FreeMemory(MachineId_t machine_id) const { return free_memory[machine_id]; }
+   // Memory held for VMs still migrating to the machine
+   unsigned Reserved(MachineId_t machine_id) const  { return reserved[machine_id]; }
+   bool IsIndexed(MachineId_t machine_id) const     { return indexed[machine_id]; }
+private:
+   std::set<std::pair<unsigned, MachineId_t>> by_free[NUM_CPU_TYPES];
+   vector<unsigned> free_memory;
+   vector<CPUType_t> cpu_of;
+   vector<bool> indexed;
+   vector<unsigned> reserved;  // by in-flight migrations, per machine
+   struct Reservation {
+      MachineId_t machine_id;
+      unsigned amount;
+   };
+   IdMap<VMId_t, Reservation> reservations;
+};
+
+
+#endif /* FreeMemoryIndex_hpp */
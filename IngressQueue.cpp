@@ -0,0 +1,55 @@
+//
+//  IngressQueue.cpp
+//  CloudSim
+//
+
+
+#include "IngressQueue.hpp"
+
+
+IngressQueue::IngressQueue(size_t capacity) : enqueue_pos(0), dequeue_pos(0) {
+   size_t size = 2;
+   while (size < capacity) size <<= 1;
+   mask = size - 1;
+   cells.reset(new Cell[size]);
+   for (size_t i = 0; i < size; i++) {
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+   }
+}
+
+
+bool IngressQueue::TryPush(const IngressEvent & event) {
+   size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+   Cell * cell;
+   for (;;) {
+      cell = &cells[pos & mask];
+      size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = intptr_t(sequence) - intptr_t(pos);
+      if (diff == 0) {
+         // The cell is free for this lap; claim it
+         if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+         // The consumer has not emptied this cell since the last lap
+         return false;
+      } else {
+         pos = enqueue_pos.load(std::memory_order_relaxed);
+      }
+   }
+   cell->event = event;
+   cell->sequence.store(pos + 1, std::memory_order_release);
+   return true;
+}
+
+
+size_t IngressQueue::PopBatch(IngressEvent * out, size_t max) {
+   size_t n = 0;
+   while (n < max) {
+      Cell & cell = cells[dequeue_pos & mask];
+      if (cell.sequence.load(std::memory_order_acquire) != dequeue_pos + 1) break;
+      out[n++] = cell.event;
+      // Hand the cell back to the producers for the next lap
+      cell.sequence.store(dequeue_pos + mask + 1, std::memory_order_release);
+      dequeue_pos++;
+   }
+   return n;
+}
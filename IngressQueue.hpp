@@ -0,0 +1,62 @@
+//
+//  IngressQueue.hpp
+//  CloudSim
+//
+//  Bounded multi-producer single-consumer queue that carries task arrivals
+//  from the load generator threads of the live shim to the thread that owns
+//  the scheduler. Every cell holds a sequence number (Vyukov's bounded
+//  queue), so producers claim a slot with one compare-and-swap and never
+//  take a lock; the consumer pops whole batches. A full queue makes TryPush()
+//  fail, which is how backpressure reaches the producers.
+//
+
+
+#ifndef IngressQueue_hpp
+#define IngressQueue_hpp
+
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "SimTypes.h"
+
+
+struct IngressEvent {
+   uint64_t enqueued_ns;       // steady clock, for the queueing latency
+   uint64_t instructions;
+   Time_t runtime;             // expected, used for the target completion
+   unsigned memory;
+   VMType_t vm_type;
+   SLAType_t sla;
+   CPUType_t cpu;
+   TaskClass_t task_class;
+   bool gpu;
+};
+
+
+class IngressQueue {
+public:
+   // `capacity` is rounded up to a power of two
+   explicit IngressQueue(size_t capacity);
+
+   // Any thread. Returns false when the queue is full.
+   bool TryPush(const IngressEvent & event);
+   // Consumer thread only. Moves up to `max` events to `out`, returns how many.
+   size_t PopBatch(IngressEvent * out, size_t max);
+
+   size_t Capacity() const     { return mask + 1; }
+private:
+   struct alignas(64) Cell {
+      std::atomic<size_t> sequence;
+      IngressEvent event;
+   };
+   std::unique_ptr<Cell[]> cells;
+   size_t mask;
+   alignas(64) std::atomic<size_t> enqueue_pos;
+   alignas(64) size_t dequeue_pos;
+};
+
+
+#endif /* IngressQueue_hpp */
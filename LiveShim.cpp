@@ -0,0 +1,450 @@
+//
+//  LiveShim.cpp
+//  CloudSim
+//
+//  Runs the scheduler against a live arrival stream instead of the event
+//  driven simulator. It takes the place of main.cpp and Simulator.o: the
+//  machine, VM and task models are linked as usual, but Now() is the wall
+//  clock (scaled by -x) and the Schedule*() calls of the models go to a timer
+//  heap that fires when wall-clock time reaches them. Producer threads stand
+//  in for real traffic and push task arrivals into a lock-free MPSC queue;
+//  the main thread owns the scheduler, pops arrivals in batches and runs the
+//  timers that are due. With -n the arrivals are only drained, which measures
+//  the ingress path on its own. With -e there is no live traffic: the tasks of
+//  the input file are replayed in simulated time through the shim's event
+//  queue, in place of Simulator.o's. Each run prints one JSON object.
+//
+//  Usage: live [-p producers] [-r rate_per_producer] [-s seconds] [-x speedup]
+//              [-b batch] [-q capacity] [-t runtime_us] [-n] [-e] [-v level] [-o output] input_file
+//
+
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unistd.h>
+
+#include "EventQueue.hpp"
+#include "IngressQueue.hpp"
+#include "Interfaces.h"
+#include "Internal_Interfaces.h"
+#include "WorkloadGen.hpp"
+
+
+using Clock = std::chrono::steady_clock;
+
+static unsigned verbose = 0;
+static unsigned producers = 4;
+static double rate = 0;                // arrivals per second per producer, 0 for as fast as possible
+static double seconds = 5;
+static double speedup = 1000;          // simulated microseconds per wall-clock microsecond
+static size_t batch_size = 256;
+static size_t capacity = 1 << 16;
+static double mean_runtime = 1000000;  // simulated us
+static bool drain_only = false;
+static const double DRAIN_LIMIT_S = 30;  // wall-clock seconds to let running tasks finish
+
+static Clock::time_point start_time;
+
+
+static uint64_t WallNs() {
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_time).count();
+}
+
+
+// Latency histogram with eight sub-buckets per power of two
+class LatencyHistogram {
+public:
+   void Add(uint64_t ns) {
+      counts[Bucket(ns)]++;
+      total++;
+      max_ns = max(max_ns, ns);
+   }
+   uint64_t Percentile(double p) const {
+      uint64_t rank = uint64_t(p * double(total));
+      uint64_t seen = 0;
+      for (unsigned b = 0; b < BUCKETS; b++) {
+         seen += counts[b];
+         if (seen > rank) return UpperBound(b);
+      }
+      return max_ns;
+   }
+   uint64_t Max() const        { return max_ns; }
+private:
+   static const unsigned BUCKETS = 64 * 8;
+   uint64_t counts[BUCKETS] = {};
+   uint64_t total = 0;
+   uint64_t max_ns = 0;
+
+   static unsigned Bucket(uint64_t ns) {
+      if (ns < 8) return unsigned(ns);
+      unsigned log = 63 - __builtin_clzll(ns);
+      return (log - 2) * 8 + unsigned((ns >> (log - 3)) & 7);
+   }
+   static uint64_t UpperBound(unsigned bucket) {
+      if (bucket < 8) return bucket;
+      unsigned log = bucket / 8 + 2;
+      return (uint64_t(8 + bucket % 8 + 1) << (log - 3)) - 1;
+   }
+};
+
+
+// Timer queue standing in for the simulator's event queue
+
+typedef enum {
+   ARRIVAL,
+   COMPLETION,
+   TIMER,
+   MIGRATION
+} LiveEventKind_t;
+
+// Events are small tagged values stored inline in the queue and dispatched
+// with a switch, no allocation or virtual call per event
+struct ArrivalEvent {
+   TaskId_t task_id;
+};
+
+struct CompletionEvent {
+   MachineId_t machine_id;
+   unsigned core_id;
+};
+
+struct MigrationEvent {
+   VMId_t vm_id;
+};
+
+struct LiveEvent {
+   LiveEventKind_t kind;
+   union {
+      ArrivalEvent arrival;
+      CompletionEvent completion;
+      MigrationEvent migration;
+   };
+
+   static LiveEvent Arrival(TaskId_t task_id)        { LiveEvent e; e.kind = ARRIVAL; e.arrival = {task_id}; return e; }
+   static LiveEvent Completion(MachineId_t machine_id, unsigned core_id) {
+      LiveEvent e;
+      e.kind = COMPLETION;
+      e.completion = {machine_id, core_id};
+      return e;
+   }
+   static LiveEvent Timer()                          { LiveEvent e; e.kind = TIMER; return e; }
+   static LiveEvent Migration(VMId_t vm_id)          { LiveEvent e; e.kind = MIGRATION; e.migration = {vm_id}; return e; }
+};
+static_assert(sizeof(LiveEvent) <= 32, "events are stored inline in the queue");
+
+static EventQueue<LiveEvent> timers;
+// The pending completion of every (machine, core), so a new projection moves it
+static unordered_map<uint64_t, EventHandle_t> completions;
+static uint64_t rescheduled = 0;
+static size_t peak_events = 0;
+
+// With -e the input's own tasks are replayed in simulated time, no wall clock
+static bool replay = false;
+static Time_t replay_clock = 0;
+
+static LatencyHistogram queue_latency;
+static LatencyHistogram new_task_latency;
+static uint64_t timer_events = 0;
+static unsigned armed_timers = 0;
+
+
+// Simulator interface, normally provided by Simulator.o
+
+Time_t Now() {
+   return replay ? replay_clock : Time_t(double(WallNs()) / 1000.0 * speedup);
+}
+
+void ScheduleNewTask(Time_t time, TaskId_t task_id)                    { timers.Push(time, LiveEvent::Arrival(task_id)); }
+void ScheduleTimer(Time_t time)                                        { timers.Push(time, LiveEvent::Timer()); armed_timers++; }
+void ScheduleMigrationCompletion(Time_t time, VMId_t vm_id)            { timers.Push(time, LiveEvent::Migration(vm_id)); }
+
+// A core has one task completing at a time; a later projection replaces the earlier one
+void ScheduleTaskCompletion(Time_t time, MachineId_t machine_id, unsigned core_id) {
+   EventHandle_t & handle = completions[(uint64_t(machine_id) << 32) | core_id];
+   if (timers.Reschedule(handle, time)) {
+      rescheduled++;
+      return;
+   }
+   handle = timers.Push(time, LiveEvent::Completion(machine_id, core_id));
+}
+
+
+// Debugging interface, normally provided by main.cpp
+
+void SimOutput(string msg, unsigned verbose_level) {
+   if (verbose_level <= verbose) {
+      cout << msg << endl;
+   }
+}
+
+void ThrowException(string err_msg) {
+   throw runtime_error(err_msg);
+}
+
+void ThrowException(string err_msg, string further_input) {
+   throw runtime_error(err_msg + further_input);
+}
+
+void ThrowException(string err_msg, unsigned further_input) {
+   throw runtime_error(err_msg + to_string(further_input));
+}
+
+
+static inline void Dispatch(Time_t time, const LiveEvent & event) {
+   switch (event.kind) {
+      case ARRIVAL:
+         if (replay) {
+            HandleNewTask(time, event.arrival.task_id);
+         } else {
+            uint64_t before = WallNs();
+            HandleNewTask(time, event.arrival.task_id);
+            new_task_latency.Add(WallNs() - before);
+         }
+         break;
+      case COMPLETION:
+         completions.erase((uint64_t(event.completion.machine_id) << 32) | event.completion.core_id);
+         Machine_CompleteTask(event.completion.machine_id, event.completion.core_id);
+         break;
+      case TIMER:
+         armed_timers--;
+         Machine_HandleTimer(time);
+         break;
+      case MIGRATION:
+         VM_MigrationCompleted(event.migration.vm_id);
+         break;
+   }
+}
+
+
+static void RunDueTimers() {
+   Time_t now = Now();
+   peak_events = max(peak_events, timers.Size());
+   while (!timers.Empty() && timers.NextTime() <= now) {
+      Time_t time;
+      LiveEvent event = timers.Pop(time);
+      timer_events++;
+      Dispatch(time, event);
+   }
+}
+
+
+// The machines only re-arm their timer while they have work, and they start
+// queued tasks from that timer. In the simulator every task is known up
+// front, here the first tick comes before any arrival, so the chain is
+// restarted whenever work shows up with no tick pending.
+static void KeepTimerArmed() {
+   if (armed_timers == 0 && GetActiveTasks() > 0) {
+      ScheduleTimer(Now());
+   }
+}
+
+
+// Load generator
+
+static atomic<bool> stopping(false);
+static atomic<uint64_t> offered(0);
+static atomic<uint64_t> stalls(0);
+
+static void Produce(IngressQueue & ingress, unsigned id) {
+   Xoshiro256 rng(0x5EED0000 + id);
+   Distribution runtime = {EXPONENTIAL, mean_runtime, 1};
+   uint64_t interval_ns = rate > 0 ? uint64_t(1e9 / rate) : 0;
+   uint64_t next_ns = WallNs();
+   uint64_t sent = 0, blocked = 0;
+
+   while (!stopping.load(std::memory_order_relaxed)) {
+      if (interval_ns) {
+         while (WallNs() < next_ns) std::this_thread::yield();
+         next_ns += interval_ns;
+      }
+      IngressEvent event;
+      event.runtime = max(Time_t(runtime.Sample(rng)), Time_t(1));
+      event.instructions = event.runtime * 1000;        // at 1000 MIPS
+      event.memory = 8;
+      event.vm_type = LINUX;
+      event.sla = SLAType_t(rng.Next() % NUM_SLAS);
+      event.cpu = X86;
+      event.task_class = WEB_REQUEST;
+      event.gpu = false;
+      event.enqueued_ns = WallNs();
+
+      // Backpressure: wait for the consumer instead of dropping
+      bool pushed = true;
+      while (!ingress.TryPush(event)) {
+         blocked++;
+         if (stopping.load(std::memory_order_relaxed)) {
+            pushed = false;
+            break;
+         }
+         std::this_thread::yield();
+      }
+      sent += pushed;
+   }
+   offered += sent;
+   stalls += blocked;
+}
+
+
+static uint64_t accepted = 0;
+static uint64_t batches = 0;
+static double consume_s = 0;
+
+static void Admit(const IngressEvent & event) {
+   queue_latency.Add(WallNs() - event.enqueued_ns);
+   if (drain_only) return;
+   Time_t now = Now();
+   AddTask(event.instructions, now, now + 2 * event.runtime, event.vm_type, event.sla, event.cpu,
+           event.gpu, event.memory, event.task_class);
+}
+
+
+// Plays the events of the input file in simulated time, as Simulator.o would
+static void Replay() {
+   uint64_t begin_ns = WallNs();
+   while (!timers.Empty()) {
+      peak_events = max(peak_events, timers.Size());
+      LiveEvent event = timers.Pop(replay_clock);
+      timer_events++;
+      Dispatch(replay_clock, event);
+   }
+   consume_s = double(WallNs() - begin_ns) / 1e9;
+   SimulationComplete(replay_clock);
+}
+
+
+// Called by Init() once the machines are built and the scheduler is ready
+void StartSimulation() {
+   if (replay) {
+      Replay();
+      return;
+   }
+   IngressQueue ingress(capacity);
+   vector<IngressEvent> batch(batch_size);
+
+   vector<thread> pool;
+   for (unsigned p = 0; p < producers; p++) {
+      pool.emplace_back(Produce, std::ref(ingress), p);
+   }
+
+   uint64_t begin_ns = WallNs();
+   uint64_t end_ns = begin_ns + uint64_t(seconds * 1e9);
+   for (;;) {
+      size_t n = ingress.PopBatch(batch.data(), batch_size);
+      if (n) batches++;
+      for (size_t i = 0; i < n; i++) {
+         Admit(batch[i]);
+      }
+      accepted += n;
+      if (!drain_only) {
+         KeepTimerArmed();
+         RunDueTimers();
+      }
+
+      if (WallNs() >= end_ns) break;
+      if (n == 0) std::this_thread::yield();
+   }
+
+   stopping = true;
+   for (thread & t : pool) {
+      t.join();
+   }
+   // Whatever made it into the queue is still admitted
+   while (size_t n = ingress.PopBatch(batch.data(), batch_size)) {
+      batches++;
+      for (size_t i = 0; i < n; i++) {
+         Admit(batch[i]);
+      }
+      accepted += n;
+   }
+   consume_s = double(WallNs() - begin_ns) / 1e9;
+
+   // Let the tasks in flight finish, the scheduler shuts its VMs down at the end
+   uint64_t give_up_ns = WallNs() + uint64_t(DRAIN_LIMIT_S * 1e9);
+   while (!drain_only && GetActiveTasks() > 0 && WallNs() < give_up_ns) {
+      KeepTimerArmed();
+      RunDueTimers();
+      std::this_thread::yield();
+   }
+   if (!drain_only && GetActiveTasks() > 0) {
+      ThrowException("StartSimulation(): Tasks still running after the drain limit: ", GetActiveTasks());
+   }
+
+   SimulationComplete(Now());
+}
+
+
+int main(int argc, char * argv[]) {
+   string output;
+   int opt;
+   while ((opt = getopt(argc, argv, "p:r:s:x:b:q:t:nev:o:")) != -1) {
+      switch (opt) {
+         case 'p': producers = max(unsigned(atoi(optarg)), 1u); break;
+         case 'r': rate = atof(optarg); break;
+         case 's': seconds = atof(optarg); break;
+         case 'x': speedup = atof(optarg); break;
+         case 'b': batch_size = max(size_t(atoi(optarg)), size_t(1)); break;
+         case 'q': capacity = size_t(atoi(optarg)); break;
+         case 't': mean_runtime = atof(optarg); break;
+         case 'n': drain_only = true; break;
+         case 'e': replay = true; break;
+         case 'v': verbose = unsigned(atoi(optarg)); break;
+         case 'o': output = optarg; break;
+         default:
+            cerr << "Usage: " << argv[0] << " [-p producers] [-r rate_per_producer] [-s seconds] [-x speedup]"
+                 << " [-b batch] [-q capacity] [-t runtime_us] [-n] [-e] [-v level] [-o output] input_file" << endl;
+            return 1;
+      }
+   }
+   if (optind >= argc) {
+      cerr << "Usage: " << argv[0] << " [-p producers] [-r rate_per_producer] [-s seconds] [-x speedup]"
+           << " [-b batch] [-q capacity] [-t runtime_us] [-n] [-e] [-v level] [-o output] input_file" << endl;
+      return 1;
+   }
+
+   // The policy's own report goes to cout; keep it out of the results
+   stringstream discarded;
+   streambuf * console = verbose ? nullptr : cout.rdbuf(discarded.rdbuf());
+
+   start_time = Clock::now();
+   try {
+      Init(argv[optind]);
+   } catch (const exception & e) {
+      if (console) cout.rdbuf(console);
+      cerr << "live: " << e.what() << endl;
+      return 1;
+   }
+   if (console) cout.rdbuf(console);
+
+   stringstream record;
+   record << "{\"mode\": \"" << (replay ? "replay" : drain_only ? "drain" : "live") << "\""
+          << ", \"producers\": " << producers
+          << ", \"seconds\": " << consume_s
+          << ", \"offered\": " << offered
+          << ", \"accepted\": " << accepted
+          << ", \"events_per_s\": " << (consume_s > 0 ? accepted / consume_s : 0)
+          << ", \"backpressure_stalls\": " << stalls
+          << ", \"mean_batch\": " << (batches ? double(accepted) / batches : 0)
+          << ", \"queue_p50_ns\": " << queue_latency.Percentile(0.5)
+          << ", \"queue_p99_ns\": " << queue_latency.Percentile(0.99)
+          << ", \"queue_max_ns\": " << queue_latency.Max()
+          << ", \"timer_events\": " << timer_events
+          << ", \"ns_per_event\": " << (timer_events ? consume_s * 1e9 / timer_events : 0)
+          << ", \"rescheduled_completions\": " << rescheduled
+          << ", \"peak_pending_events\": " << peak_events
+          << ", \"new_task_p50_ns\": " << new_task_latency.Percentile(0.5)
+          << ", \"new_task_p99_ns\": " << new_task_latency.Percentile(0.99)
+          << ", \"tasks_completed\": " << (drain_only ? 0 : GetNumTasks() - GetActiveTasks())
+          << ", \"energy_kwh\": " << Machine_GetClusterEnergy()
+          << "}";
+
+   if (output.empty()) {
+      cout << record.str() << endl;
+   } else {
+      ofstream(output, ios::app) << record.str() << endl;
+   }
+   return 0;
+}
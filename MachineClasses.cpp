@@ -0,0 +1,91 @@
+//
+//  MachineClasses.cpp
+//  CloudSim
+//
+
+
+#include "MachineClasses.hpp"
+
+#include <cstring>
+
+
+void MachineClasses::Init(unsigned total_machines) {
+   classes.clear();
+   class_of.assign(total_machines, 0);
+   // Hash of every class's hardware, so a machine that does not match its
+   // neighbour is compared in full only against likely classes
+   vector<uint64_t> hashes;
+
+   for (unsigned i = 0; i < total_machines; i++) {
+      MachineClass machine_class = Describe(Machine_GetInfo(MachineId_t(i)));
+      if (i > 0 && SameHardware(classes[class_of[i - 1]], machine_class)) {
+         class_of[i] = class_of[i - 1];
+         classes[class_of[i]].machines++;
+         continue;
+      }
+
+      uint64_t hash = Hash(machine_class);
+      unsigned class_id = 0;
+      while (class_id < classes.size() && (hashes[class_id] != hash || !SameHardware(classes[class_id], machine_class))) {
+         class_id++;
+      }
+      if (class_id == classes.size()) {
+         machine_class.first = MachineId_t(i);
+         classes.push_back(machine_class);
+         hashes.push_back(hash);
+         SimOutput("MachineClasses::Init(): Class " + to_string(class_id) + " starts at machine " + to_string(i), 3);
+      }
+      class_of[i] = class_id;
+      classes[class_id].machines++;
+   }
+}
+
+
+MachineClass MachineClasses::Describe(const MachineInfo_t & m_info) {
+   MachineClass machine_class = {};
+   machine_class.cpu = m_info.cpu;
+   machine_class.num_cpus = max(m_info.num_cpus, 1u);
+   machine_class.memory_size = m_info.memory_size;
+   machine_class.gpus = m_info.gpus;
+   for (unsigned p = 0; p < P_STATES; p++) {
+      machine_class.mips[p] = p < m_info.performance.size() ? max(m_info.performance[p], 1u) : 1;
+      machine_class.core_power[p] = p < m_info.p_states.size() ? m_info.p_states[p] : 0;
+   }
+   for (unsigned c = 0; c < C_STATES && c < m_info.c_states.size(); c++) {
+      machine_class.c_states[c] = m_info.c_states[c];
+   }
+   machine_class.has_s_states = m_info.s_states.size() == S_STATES;
+   for (unsigned s = 0; s < S_STATES && machine_class.has_s_states; s++) {
+      machine_class.s_states[s] = m_info.s_states[s];
+   }
+   return machine_class;
+}
+
+
+bool MachineClasses::SameHardware(const MachineClass & a, const MachineClass & b) {
+   return a.cpu == b.cpu && a.num_cpus == b.num_cpus && a.memory_size == b.memory_size && a.gpus == b.gpus &&
+          a.has_s_states == b.has_s_states &&
+          memcmp(a.mips, b.mips, sizeof(a.mips)) == 0 && memcmp(a.core_power, b.core_power, sizeof(a.core_power)) == 0 &&
+          memcmp(a.c_states, b.c_states, sizeof(a.c_states)) == 0 && memcmp(a.s_states, b.s_states, sizeof(a.s_states)) == 0;
+}
+
+
+uint64_t MachineClasses::Hash(const MachineClass & machine_class) {
+   // FNV-1a over the hardware fields
+   uint64_t hash = 0xcbf29ce484222325ull;
+   auto mix = [&hash](unsigned value) {
+      hash ^= value;
+      hash *= 0x100000001b3ull;
+   };
+   mix(machine_class.cpu);
+   mix(machine_class.num_cpus);
+   mix(machine_class.memory_size);
+   mix(machine_class.gpus);
+   for (unsigned p = 0; p < P_STATES; p++) {
+      mix(machine_class.mips[p]);
+      mix(machine_class.core_power[p]);
+   }
+   for (unsigned c = 0; c < C_STATES; c++) mix(machine_class.c_states[c]);
+   for (unsigned s = 0; s < S_STATES; s++) mix(machine_class.s_states[s]);
+   return hash;
+}
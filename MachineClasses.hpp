@@ -0,0 +1,58 @@
+//
+//  MachineClasses.hpp
+//  CloudSim
+//
+//  Machines built from the same `machine class:` block share their hardware:
+//  CPU, cores, memory, GPU, MIPS and the S-, C- and P-state power tables.
+//  The registry reads every machine once at Init, keeps one immutable table
+//  per class and maps machines to their class id, so the rest of the
+//  scheduler looks class data up instead of copying it out of a
+//  MachineInfo_t per machine. Machines of a class are usually contiguous, so
+//  classifying a machine is normally one comparison with its neighbour.
+//
+
+
+#ifndef MachineClasses_hpp
+#define MachineClasses_hpp
+
+
+#include <vector>
+
+#include "Interfaces.h"
+
+
+struct MachineClass {
+   CPUType_t cpu;
+   unsigned num_cpus;
+   unsigned memory_size;
+   bool gpus;
+   unsigned mips[P_STATES];
+   unsigned core_power[P_STATES];      // one core running at the P-state
+   unsigned c_states[C_STATES];        // one core in the C-state
+   unsigned s_states[S_STATES];        // the whole machine; all zero when the simulator does not report them
+   bool has_s_states;
+   unsigned machines;                  // machines of this class
+   MachineId_t first;                  // lowest machine id of this class
+};
+
+
+class MachineClasses {
+public:
+   MachineClasses()            {}
+   void Init(unsigned total_machines);
+
+   unsigned ClassOf(MachineId_t machine_id) const             { return class_of[machine_id]; }
+   const MachineClass & Class(unsigned class_id) const        { return classes[class_id]; }
+   const MachineClass & OfMachine(MachineId_t machine_id) const   { return classes[class_of[machine_id]]; }
+   unsigned NumClasses() const                                { return unsigned(classes.size()); }
+private:
+   vector<MachineClass> classes;
+   vector<unsigned> class_of;
+
+   static MachineClass Describe(const MachineInfo_t & m_info);
+   static bool SameHardware(const MachineClass & a, const MachineClass & b);
+   static uint64_t Hash(const MachineClass & machine_class);
+};
+
+
+#endif /* MachineClasses_hpp */
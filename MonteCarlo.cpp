@@ -0,0 +1,196 @@
+//
+//  MonteCarlo.cpp
+//  CloudSim
+//
+//  Runs K replicas of the simulator on the same input, each with its task
+//  class seeds derived from the replica number, and reports the mean and 95%
+//  confidence interval of the energy and SLA results. Every replica is its own
+//  simulator process, so replicas share no state and run in parallel.
+//
+//  Usage: montecarlo [-k replicas] [-j workers] [-w relative_ci_width] [-s simulator] input_file
+//
+
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+
+#define NUM_METRICS 4
+static const char * metric_names[NUM_METRICS] = {"Energy (KW-Hour)", "SLA0 (%)", "SLA1 (%)", "SLA2 (%)"};
+static const unsigned MIN_REPLICAS = 3;
+
+
+// Welford's running mean and variance
+struct Estimate {
+   unsigned n = 0;
+   double mean = 0;
+   double m2 = 0;
+
+   void Add(double x) {
+      n++;
+      double delta = x - mean;
+      mean += delta / n;
+      m2 += delta * (x - mean);
+   }
+
+   // Half width of the 95% confidence interval of the mean
+   double HalfWidth() const {
+      static const double t_table[] = {0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262,
+                                       2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093,
+                                       2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045};
+      if (n < 2) return INFINITY;
+      unsigned df = n - 1;
+      double t = df < sizeof(t_table) / sizeof(t_table[0]) ? t_table[df] : 1.96;
+      return t * sqrt(m2 / df / n);
+   }
+};
+
+
+// splitmix64, so that nearby replica numbers still give unrelated seeds
+static uint64_t DeriveSeed(uint64_t seed, uint64_t replica) {
+   uint64_t z = seed + (replica + 1) * 0x9E3779B97F4A7C15ull;
+   z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+   z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+   return (z ^ (z >> 31)) & 0x7FFFFFFF;
+}
+
+
+static string WithDerivedSeeds(const string & input, unsigned replica) {
+   stringstream in(input);
+   string out, line;
+   while (getline(in, line)) {
+      size_t key = line.find("Seed");
+      size_t colon = line.find(':', key);
+      if (key != string::npos && colon != string::npos) {
+         uint64_t seed = strtoull(line.c_str() + colon + 1, nullptr, 10);
+         line = line.substr(0, colon + 1) + " " + to_string(DeriveSeed(seed, replica));
+      }
+      out += line + "\n";
+   }
+   return out;
+}
+
+
+// Runs one replica and pulls the results out of the simulator's report
+static bool RunReplica(const string & simulator, const string & input_file, double metrics[NUM_METRICS]) {
+   FILE * pipe = popen((simulator + " " + input_file + " 2>/dev/null").c_str(), "r");
+   if (pipe == nullptr) return false;
+
+   unsigned found = 0;
+   char buffer[512];
+   while (fgets(buffer, sizeof(buffer), pipe)) {
+      string line(buffer);
+      if (line.compare(0, 12, "Total Energy") == 0) {
+         metrics[0] = atof(line.c_str() + 12);
+         found++;
+      }
+      for (unsigned sla = 0; sla < 3; sla++) {
+         string key = "SLA" + to_string(sla) + ":";
+         if (line.compare(0, key.size(), key) == 0) {
+            metrics[sla + 1] = atof(line.c_str() + key.size());
+            found++;
+         }
+      }
+   }
+   return pclose(pipe) == 0 && found >= NUM_METRICS;
+}
+
+
+int main(int argc, char * argv[]) {
+   unsigned replicas = 10;
+   unsigned workers = max(thread::hardware_concurrency(), 1u);
+   double target_width = 0;
+   string simulator = "./simulator";
+
+   int opt;
+   while ((opt = getopt(argc, argv, "k:j:w:s:")) != -1) {
+      switch (opt) {
+         case 'k': replicas = unsigned(atoi(optarg)); break;
+         case 'j': workers = max(unsigned(atoi(optarg)), 1u); break;
+         case 'w': target_width = atof(optarg); break;
+         case 's': simulator = optarg; break;
+         default:
+            cerr << "Usage: " << argv[0] << " [-k replicas] [-j workers] [-w relative_ci_width] [-s simulator] input_file" << endl;
+            return 1;
+      }
+   }
+   if (optind >= argc) {
+      cerr << "Usage: " << argv[0] << " [-k replicas] [-j workers] [-w relative_ci_width] [-s simulator] input_file" << endl;
+      return 1;
+   }
+
+   ifstream file(argv[optind]);
+   if (!file) {
+      cerr << "montecarlo: cannot open " << argv[optind] << endl;
+      return 1;
+   }
+   stringstream contents;
+   contents << file.rdbuf();
+   string input = contents.str();
+
+   Estimate estimates[NUM_METRICS];
+   mutex lock;
+   atomic<unsigned> next_replica(0);
+   atomic<bool> converged(false);
+   atomic<unsigned> failures(0);
+
+   auto worker = [&]() {
+      while (!converged) {
+         unsigned replica = next_replica++;
+         if (replica >= replicas) return;
+
+         string replica_file = "/tmp/cloudsim_mc_" + to_string(getpid()) + "_" + to_string(replica) + ".md";
+         ofstream(replica_file) << WithDerivedSeeds(input, replica);
+
+         double metrics[NUM_METRICS] = {};
+         bool ok = RunReplica(simulator, replica_file, metrics);
+         remove(replica_file.c_str());
+         if (!ok) {
+            failures++;
+            cerr << "montecarlo: replica " << replica << " failed" << endl;
+            continue;
+         }
+
+         lock_guard<mutex> guard(lock);
+         for (unsigned m = 0; m < NUM_METRICS; m++) {
+            estimates[m].Add(metrics[m]);
+         }
+         cerr << "replica " << replica << ": energy " << metrics[0] << " KW-Hour" << endl;
+
+         // Stop handing out replicas once the energy estimate is tight enough
+         const Estimate & energy = estimates[0];
+         if (target_width > 0 && energy.n >= MIN_REPLICAS &&
+             2 * energy.HalfWidth() <= target_width * fabs(energy.mean)) {
+            converged = true;
+         }
+      }
+   };
+
+   vector<thread> pool;
+   for (unsigned w = 0; w < min(workers, replicas); w++) {
+      pool.emplace_back(worker);
+   }
+   for (thread & t : pool) {
+      t.join();
+   }
+
+   cout << "Replicas: " << estimates[0].n << (converged ? " (converged)" : "") << endl;
+   for (unsigned m = 0; m < NUM_METRICS; m++) {
+      const Estimate & e = estimates[m];
+      cout << metric_names[m] << ": mean " << e.mean << ", 95% CI [" << e.mean - e.HalfWidth()
+           << ", " << e.mean + e.HalfWidth() << "]" << endl;
+   }
+   return failures == 0 ? 0 : 1;
+}
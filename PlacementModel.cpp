@@ -0,0 +1,141 @@
+//
+//  PlacementModel.cpp
+//  CloudSim
+//
+
+
+#include "PlacementModel.hpp"
+
+#include <cmath>
+#include <fstream>
+
+
+static const float LEARNING_RATE = 0.01f;
+static const double MIN_EXPLORATION = 0.02;
+
+
+// Starting point until the model has seen some completions: roughly the
+// hand-written ranking (deadline first, then energy per instruction, then load)
+// with a steep price on oversubscribed cores
+PlacementModel::PlacementModel() {
+   static const float prior[MODEL_FEATURES] = {0.5f, 0.3f, 0.1f, 0.0f, 1.0f, 1.0f, 0.0f, 3.0f, 0.0f, 0.2f, 0.1f, 4.0f};
+   for (unsigned i = 0; i < MODEL_FEATURES; i++) {
+      weights[i] = prior[i];
+   }
+}
+
+
+bool PlacementModel::Load(const string & filename) {
+   ifstream in(filename);
+   if (!in) return false;
+
+   string magic;
+   unsigned features;
+   in >> magic >> features;
+   if (magic != "PlacementModel" || features != MODEL_FEATURES) {
+      ThrowException("PlacementModel::Load(): Not a model with matching features: ", filename);
+   }
+   for (unsigned i = 0; i < MODEL_FEATURES; i++) {
+      in >> weights[i];
+   }
+   in >> mean_energy >> updates;
+   if (!in) {
+      ThrowException("PlacementModel::Load(): Truncated model file ", filename);
+   }
+   SimOutput("PlacementModel::Load(): Loaded weights trained on " + to_string(updates) + " tasks", 1);
+   return true;
+}
+
+
+void PlacementModel::Save(const string & filename) const {
+   ofstream out(filename);
+   if (!out) {
+      ThrowException("PlacementModel::Save(): Could not write ", filename);
+   }
+   out.precision(9);
+   out << "PlacementModel " << MODEL_FEATURES << "\n";
+   for (unsigned i = 0; i < MODEL_FEATURES; i++) {
+      out << weights[i] << (i + 1 < MODEL_FEATURES ? " " : "\n");
+   }
+   out << mean_energy << " " << updates << "\n";
+}
+
+
+PlacementFeatures PlacementModel::Features(const MachineInfo_t & m_info, const TaskInfo_t & task_info, double score,
+                                           bool on_time, unsigned vm_load, unsigned packed, bool new_vm) const {
+   float cores = float(max(m_info.num_cpus, 1u));
+   float memory = float(max(m_info.memory_size, 1u));
+   float needed = float(task_info.required_memory + (new_vm ? VM_MEMORY_OVERHEAD : 0));
+   float late = on_time ? 0.0f : 1.0f;
+   float urgency = float(SLA3 - task_info.required_sla) / float(SLA3);
+
+   PlacementFeatures f;
+   f.x[0] = 1.0f;
+   f.x[1] = min(float(m_info.active_tasks) / cores, 2.0f);
+   f.x[2] = min((float(m_info.memory_used) + needed) / memory, 2.0f);
+   f.x[3] = float(m_info.p_state) / float(P_STATES - 1);
+   f.x[4] = float(score / max_score);
+   f.x[5] = late;
+   f.x[6] = urgency;
+   f.x[7] = late * urgency;
+   f.x[8] = 1.0f / float(1 + packed);
+   f.x[9] = new_vm ? 1.0f : 0.0f;
+   f.x[10] = min(float(vm_load) / cores, 2.0f);
+   // Tasks start sharing cores past this point, which is where deadlines slip
+   f.x[11] = min(max(float(m_info.active_tasks + 1) - cores, 0.0f) / cores, 2.0f);
+   return f;
+}
+
+
+uint64_t PlacementModel::NextRandom() {
+   // xorshift64
+   rng ^= rng << 13;
+   rng ^= rng >> 7;
+   rng ^= rng << 17;
+   return rng;
+}
+
+
+bool PlacementModel::Explore() {
+   double epsilon = max(MIN_EXPLORATION, 0.2 / sqrt(1.0 + double(updates) / 100.0));
+   return double(NextRandom() >> 11) * 0x1.0p-53 < epsilon;
+}
+
+
+float PlacementModel::Noise() {
+   return float(NextRandom() >> 40);
+}
+
+
+void PlacementModel::Placed(TaskId_t task_id, MachineId_t machine_id, const PlacementFeatures & features) {
+   outstanding[task_id] = {features, machine_id, Machine_GetEnergy(machine_id)};
+}
+
+
+void PlacementModel::Completed(TaskId_t task_id, unsigned sharing, bool violated) {
+   auto it = outstanding.find(task_id);
+   if (it == outstanding.end()) return;
+   Outstanding placed = it->second;
+   outstanding.erase(it);
+
+   uint64_t energy_now = Machine_GetEnergy(placed.machine_id);
+   double share = double(energy_now - min(placed.energy_at_start, energy_now)) / max(sharing, 1u);
+   mean_energy = updates == 0 ? share : 0.999 * mean_energy + 0.001 * share;
+
+   // Observed cost on the same scale as the prior: energy near 1, a missed
+   // SLA worth up to 16
+   const float * x = placed.features.x;
+   float cost = float(share / max(mean_energy, 1e-9));
+   if (violated) cost += 4.0f + 12.0f * x[6];
+
+   // Normalised LMS step
+   float error = cost - Predict(placed.features);
+   float norm = 1.0f;
+   for (unsigned i = 0; i < MODEL_FEATURES; i++) norm += x[i] * x[i];
+   for (unsigned i = 0; i < MODEL_FEATURES; i++) {
+      weights[i] += LEARNING_RATE * error * x[i] / norm;
+   }
+   updates++;
+   run_updates++;
+   total_error += fabs(error);
+}
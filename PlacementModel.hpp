@@ -0,0 +1,84 @@
+//
+//  PlacementModel.hpp
+//  CloudSim
+//
+//  Online linear model of what a placement costs. Every candidate host is
+//  described by a handful of features (core and memory utilisation, core
+//  oversubscription, P-state, energy per instruction, deadline slack, SLA,
+//  rack packing, VM load); the model predicts the cost as a dot product, so
+//  ranking a candidate is a few multiply-adds. When a task completes, its
+//  cost is observed (its share of the host's energy while it ran, plus a
+//  penalty if it missed its SLA) and the weights take one SGD step.
+//  Candidates are picked epsilon-greedily so the model keeps exploring.
+//  Weights are saved and loaded as plain text.
+//
+
+
+#ifndef PlacementModel_hpp
+#define PlacementModel_hpp
+
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "Interfaces.h"
+
+
+#define MODEL_FEATURES 12
+
+
+struct PlacementFeatures {
+   float x[MODEL_FEATURES];
+};
+
+
+class PlacementModel {
+public:
+   PlacementModel();
+   // `max_score` scales the energy-per-instruction feature into [0, 1]
+   void Init(double max_score)                      { this->max_score = max_score > 0 ? max_score : 1; }
+   // Returns false if the file does not exist; throws if it is malformed
+   bool Load(const string & filename);
+   void Save(const string & filename) const;
+
+   PlacementFeatures Features(const MachineInfo_t & m_info, const TaskInfo_t & task_info, double score,
+                              bool on_time, unsigned vm_load, unsigned packed, bool new_vm) const;
+   float Predict(const PlacementFeatures & features) const {
+      float cost = 0;
+      for (unsigned i = 0; i < MODEL_FEATURES; i++) cost += weights[i] * features.x[i];
+      return cost;
+   }
+
+   // Decides once per task whether to explore; while exploring, candidates
+   // are ranked by Noise() instead of Predict(), i.e. picked at random
+   bool Explore();
+   float Noise();
+
+   void Placed(TaskId_t task_id, MachineId_t machine_id, const PlacementFeatures & features);
+   // `sharing` is the number of tasks the host's energy is split between
+   void Completed(TaskId_t task_id, unsigned sharing, bool violated);
+
+   uint64_t Updates() const    { return updates; }
+   // Over this run only
+   double MeanError() const    { return run_updates ? total_error / run_updates : 0; }
+private:
+   struct Outstanding {
+      PlacementFeatures features;
+      MachineId_t machine_id;
+      uint64_t energy_at_start;
+   };
+   float weights[MODEL_FEATURES];
+   double max_score = 1;
+   double mean_energy = 0;     // running mean of the observed energy, to keep costs near 1
+   uint64_t updates = 0;
+   uint64_t run_updates = 0;
+   double total_error = 0;
+   uint64_t rng = 0x9E3779B97F4A7C15ull;
+   std::unordered_map<TaskId_t, Outstanding> outstanding;
+
+   uint64_t NextRandom();
+};
+
+
+#endif /* PlacementModel_hpp */
@@ -0,0 +1,55 @@
+//
+//  PlacementScorer.cpp
+//  CloudSim
+//
+
+
+#include "PlacementScorer.hpp"
+
+
+void PlacementScorer::Init(const MachineClasses & machine_classes) {
+   this->machine_classes = &machine_classes;
+   scores.resize(machine_classes.NumClasses());
+   for (unsigned c = 0; c < machine_classes.NumClasses(); c++) {
+      const MachineClass & machine_class = machine_classes.Class(c);
+      MachineClassScore & score = scores[c];
+      // The simulator does not always fill in s_states; without it the idle
+      // (C1) draw of all cores is the best estimate of the machine's S0 power.
+      if (machine_class.has_s_states) {
+         score.wake_power = machine_class.s_states[S0];
+      } else {
+         score.wake_power = machine_class.num_cpus * machine_class.c_states[C1];
+      }
+      for (unsigned p = 0; p < P_STATES; p++) {
+         double power = machine_class.core_power[p] + double(score.wake_power) / machine_class.num_cpus;
+         score.energy_per_instruction[p] = power / machine_class.mips[p];
+      }
+      SimOutput("PlacementScorer::Init(): Class " + to_string(c) + ", P0 energy per instruction " +
+                to_string(score.energy_per_instruction[P0]), 3);
+   }
+}
+
+
+double PlacementScorer::Score(const MachineInfo_t & m_info) const {
+   unsigned class_id = machine_classes->ClassOf(m_info.machine_id);
+   const MachineClassScore & score = scores[class_id];
+   double cost = score.energy_per_instruction[m_info.p_state];
+   if (m_info.s_state != S0) {
+      cost += double(score.wake_power) / machine_classes->Class(class_id).mips[P0];
+   }
+   return cost;
+}
+
+
+bool PlacementScorer::MeetsDeadline(const MachineInfo_t & m_info, const TaskInfo_t & task_info, Time_t now) const {
+   const MachineClass & machine_class = machine_classes->OfMachine(m_info.machine_id);
+
+   // MIPS is instructions per microsecond; once the cores are oversubscribed
+   // every task gets a proportional share of one.
+   double runtime = double(task_info.remaining_instructions) / machine_class.mips[m_info.p_state];
+   unsigned sharing = m_info.active_tasks + 1;
+   if (sharing > machine_class.num_cpus) {
+      runtime = runtime * sharing / machine_class.num_cpus;
+   }
+   return now + Time_t(runtime) <= task_info.target_completion;
+}
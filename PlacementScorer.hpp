@@ -0,0 +1,50 @@
+//
+//  PlacementScorer.hpp
+//  CloudSim
+//
+//  Ranks hosts by how much energy they spend per instruction. Every machine
+//  class gets a table of energy-per-instruction for each P-state, so scoring
+//  a host is a table lookup.
+//
+
+
+#ifndef PlacementScorer_hpp
+#define PlacementScorer_hpp
+
+
+#include <vector>
+
+#include "Interfaces.h"
+#include "MachineClasses.hpp"
+
+
+// Derived per machine class
+struct MachineClassScore {
+   // Core power at the P-state plus the machine's S0 power shared by its
+   // cores, divided by MIPS: the cost of one instruction on a busy host.
+   double energy_per_instruction[P_STATES];
+   // Power drawn just for being on, charged when a host has to be woken up
+   unsigned wake_power;
+};
+
+
+class PlacementScorer {
+public:
+   PlacementScorer()           {}
+   void Init(const MachineClasses & machine_classes);
+
+   const MachineClassScore & Class(unsigned class_id) const { return scores[class_id]; }
+
+   // Lower is better. Sleeping hosts pay for their S0 power on top.
+   double Score(const MachineInfo_t & m_info) const;
+
+   // Whether the task can still finish by its target on this host, given the
+   // current P-state and how many tasks already share its cores.
+   bool MeetsDeadline(const MachineInfo_t & m_info, const TaskInfo_t & task_info, Time_t now) const;
+private:
+   const MachineClasses * machine_classes = nullptr;
+   vector<MachineClassScore> scores;
+};
+
+
+#endif /* PlacementScorer_hpp */
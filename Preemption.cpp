@@ -0,0 +1,84 @@
+//
+//  Preemption.cpp
+//  CloudSim
+//
+
+
+#include "Preemption.hpp"
+
+
+void Preemption::Started(VMId_t vm_id, const TaskInfo_t & task_info) {
+   bool urgent = Urgent(task_info.required_sla);
+   if (!urgent && task_info.required_sla != SLA3) return;
+   Completed(task_info.task_id);
+
+   VMTasks & tasks = vm_tasks[vm_id];
+   Running task = {vm_id, uint32_t(tasks.best_effort.size()), task_info.priority, urgent, false, false};
+   if (urgent) tasks.urgent++;
+   else tasks.best_effort.push_back(task_info.task_id);
+   running[task_info.task_id] = task;
+}
+
+
+void Preemption::Completed(TaskId_t task_id) {
+   auto it = running.find(task_id);
+   if (it == running.end()) return;
+   const Running & task = it->second;
+   VMTasks & tasks = vm_tasks.Get(task.vm_id);
+   if (task.urgent) {
+      tasks.urgent--;
+   } else {
+      // Fill the gap with the VM's last best-effort task
+      TaskId_t last = tasks.best_effort.back();
+      tasks.best_effort[task.position] = last;
+      running.find(last)->second.position = task.position;
+      tasks.best_effort.pop_back();
+      if (task.suspended) suspended--;
+   }
+   running.erase(it);
+}
+
+
+void Preemption::Pin(TaskId_t task_id) {
+   auto it = running.find(task_id);
+   if (it == running.end() || it->second.urgent) return;
+   it->second.pinned = true;
+   if (it->second.suspended) {
+      it->second.suspended = false;
+      suspended--;
+   }
+}
+
+
+void Preemption::Update(MachineId_t machine_id, unsigned num_cpus, unsigned active_tasks,
+                        vector<std::pair<TaskId_t, Priority_t>> & changes) {
+   unsigned running_urgent = 0;
+   unsigned running_best_effort = 0;
+   for (VMId_t vm_id : machine_vms->Of(machine_id)) {
+      if (!vm_tasks.Contains(vm_id)) continue;
+      running_urgent += vm_tasks.Get(vm_id).urgent;
+      running_best_effort += unsigned(vm_tasks.Get(vm_id).best_effort.size());
+   }
+   if (running_best_effort == 0) return;
+
+   // Suspend while the urgent tasks would otherwise share cores with best-effort ones
+   bool suspend = running_urgent > 0 && active_tasks > num_cpus;
+   if (!suspend && suspended == 0) return;
+   for (VMId_t vm_id : machine_vms->Of(machine_id)) {
+      if (!vm_tasks.Contains(vm_id)) continue;
+      for (TaskId_t task_id : vm_tasks.Get(vm_id).best_effort) {
+         Running & task = running.find(task_id)->second;
+         if (task.pinned || task.suspended == suspend) continue;
+         task.suspended = suspend;
+         if (suspend) {
+            suspended++;
+            suspensions++;
+            changes.push_back({task_id, LOW_PRIORITY});
+         } else {
+            suspended--;
+            resumptions++;
+            changes.push_back({task_id, task.priority});
+         }
+      }
+   }
+}
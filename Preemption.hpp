@@ -0,0 +1,75 @@
+//
+//  Preemption.hpp
+//  CloudSim
+//
+//  Lets best-effort (SLA3) tasks give their cores to urgent (SLA0 and SLA1)
+//  work. The simulator cannot take a task off a machine: VM_RemoveTask only
+//  drops it from the VM's list, while the machine keeps its memory, its core
+//  and its completion event. What it does honour is priority: a core runs
+//  its highest priority tasks and the others wait, keeping their remaining
+//  instructions. So a host's SLA3 tasks are suspended by lowering them to
+//  LOW_PRIORITY while urgent work shares its cores, and resumed at their own
+//  priority once the urgent tasks have finished or the cores are no longer
+//  oversubscribed.
+//
+//  Tasks are tracked by VM, so VMs that migrate take their tasks along.
+//  Only running tasks are held, in a hash map, since task ids keep growing
+//  over a trace.
+//
+
+
+#ifndef Preemption_hpp
+#define Preemption_hpp
+
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "DenseId.hpp"
+#include "Interfaces.h"
+
+
+class Preemption {
+public:
+   Preemption()                {}
+   void Init(const IdLists<MachineId_t, VMId_t> & machine_vms)   { this->machine_vms = &machine_vms; }
+
+   static bool Urgent(SLAType_t sla)     { return sla == SLA0 || sla == SLA1; }
+
+   void Started(VMId_t vm_id, const TaskInfo_t & task_info);
+   void Completed(TaskId_t task_id);
+   // The task was lowered for good elsewhere (memory overflow) and is left alone
+   void Pin(TaskId_t task_id);
+
+   // Suspends or resumes the host's SLA3 tasks for its current load. The
+   // priorities to set are appended to `changes`.
+   void Update(MachineId_t machine_id, unsigned num_cpus, unsigned active_tasks,
+               vector<std::pair<TaskId_t, Priority_t>> & changes);
+
+   uint64_t Suspensions() const   { return suspensions; }
+   uint64_t Resumptions() const   { return resumptions; }
+private:
+   struct Running {
+      VMId_t vm_id;
+      uint32_t position;       // in the VM's best-effort list
+      Priority_t priority;     // as placed
+      bool urgent;
+      bool suspended;
+      bool pinned;
+   };
+   struct VMTasks {
+      vector<TaskId_t> best_effort;   // running SLA3 tasks
+      unsigned urgent = 0;            // running SLA0 and SLA1 tasks
+   };
+
+   const IdLists<MachineId_t, VMId_t> * machine_vms = nullptr;
+   std::unordered_map<TaskId_t, Running> running;   // urgent and SLA3 tasks only
+   IdMap<VMId_t, VMTasks> vm_tasks;
+   unsigned suspended = 0;
+   uint64_t suspensions = 0;
+   uint64_t resumptions = 0;
+};
+
+
+#endif /* Preemption_hpp */
@@ -0,0 +1,98 @@
+//
+//  RuntimePredictor.cpp
+//  CloudSim
+//
+
+
+#include "RuntimePredictor.hpp"
+
+#include <cmath>
+
+
+void RuntimePredictor::Init(const MachineClasses & machine_classes) {
+   this->machine_classes = &machine_classes;
+   cells.assign(size_t(machine_classes.NumClasses()) * P_STATES * KINDS, Slowdown());
+   hosts.assign(Machine_GetTotal(), Host());
+}
+
+
+unsigned RuntimePredictor::Kind(const TaskInfo_t & task_info) {
+   // Instruction counts in steps of 16x, from about a million up
+   uint64_t instructions = max(task_info.total_instructions, uint64_t(1));
+   unsigned magnitude = unsigned(63 - __builtin_clzll(instructions)) / 4;
+   unsigned size = min(magnitude > 5 ? magnitude - 5 : 0, SIZES - 1);
+   return (unsigned(task_info.required_vm) % VM_TYPES * 2 + (task_info.gpu_capable ? 1 : 0)) * SIZES + size;
+}
+
+
+// Like PlacementScorer::MeetsDeadline(): the remaining instructions at the
+// P-state's MIPS, stretched once the cores are oversubscribed
+double RuntimePredictor::Ideal(const MachineInfo_t & m_info, const TaskInfo_t & task_info) const {
+   const MachineClass & machine_class = machine_classes->OfMachine(m_info.machine_id);
+   double runtime = double(task_info.remaining_instructions) / max(machine_class.mips[m_info.p_state], 1u);
+   unsigned sharing = m_info.active_tasks + 1;
+   if (sharing > machine_class.num_cpus) {
+      runtime = runtime * sharing / max(machine_class.num_cpus, 1u);
+   }
+   return runtime;
+}
+
+
+float RuntimePredictor::Factor(uint32_t cell, unsigned kind) const {
+   if (cells[cell].samples > 0) return cells[cell].mean;
+   return kinds[kind].samples > 0 ? kinds[kind].mean : 1;
+}
+
+
+Time_t RuntimePredictor::Predict(const MachineInfo_t & m_info, const TaskInfo_t & task_info) const {
+   unsigned kind = Kind(task_info);
+   uint32_t cell = (machine_classes->ClassOf(m_info.machine_id) * P_STATES + m_info.p_state) * KINDS + kind;
+   return Time_t(Ideal(m_info, task_info) * Factor(cell, kind));
+}
+
+
+Time_t RuntimePredictor::Started(Time_t now, const MachineInfo_t & m_info, const TaskInfo_t & task_info) {
+   Running & task = running[task_info.task_id];
+   task.kind = uint16_t(Kind(task_info));
+   task.cell = (machine_classes->ClassOf(m_info.machine_id) * P_STATES + m_info.p_state) * KINDS + task.kind;
+   task.ideal = Ideal(m_info, task_info);
+   task.predicted = Time_t(task.ideal * Factor(task.cell, task.kind));
+   task.start = now;
+   task.machine_id = m_info.machine_id;
+
+   Host & host = hosts[m_info.machine_id];
+   host.drain = host.tasks > 0 ? max(host.drain, now + task.predicted) : now + task.predicted;
+   host.tasks++;
+   return now + task.predicted;
+}
+
+
+void RuntimePredictor::Completed(Time_t now, TaskId_t task_id) {
+   auto it = running.find(task_id);
+   if (it == running.end()) return;
+   Running task = it->second;
+   running.erase(it);
+   hosts[task.machine_id].tasks--;
+
+   double runtime = double(now - task.start);
+   if (task.ideal <= 0 || runtime <= 0) return;
+   float observed = float(runtime / task.ideal);
+   cells[task.cell].Add(observed);
+   kinds[task.kind].Add(observed);
+   samples++;
+   total_error += fabs(double(task.predicted) - runtime) / runtime;
+}
+
+
+void RuntimePredictor::Moved(TaskId_t task_id, MachineId_t destination) {
+   auto it = running.find(task_id);
+   if (it == running.end() || it->second.machine_id == destination) return;
+   Running & task = it->second;
+   hosts[task.machine_id].tasks--;
+   task.machine_id = destination;
+
+   Host & host = hosts[destination];
+   Time_t finish = task.start + task.predicted;
+   host.drain = host.tasks > 0 ? max(host.drain, finish) : finish;
+   host.tasks++;
+}
@@ -0,0 +1,92 @@
+//
+//  RuntimePredictor.hpp
+//  CloudSim
+//
+//  Learns how long tasks actually run. A task's runtime on an idle host is
+//  its instructions over the host's MIPS at the current P-state; what the
+//  predictor learns is the slowdown on top of that (shared cores, P-state
+//  changes), for each machine class, P-state and kind of task. Policies
+//  don't see a task's TaskClass_t, so the kind is inferred from what they
+//  do see: VM type, GPU and the magnitude of the instruction count. Each
+//  slowdown is a running mean updated when a task completes, and kinds of
+//  task a class has not run yet borrow the slowdown seen on other classes.
+//  Predicting a runtime, and the time a host drains of its tasks, is a
+//  table lookup.
+//
+
+
+#ifndef RuntimePredictor_hpp
+#define RuntimePredictor_hpp
+
+
+#include <unordered_map>
+#include <vector>
+
+#include "Interfaces.h"
+#include "MachineClasses.hpp"
+
+
+class RuntimePredictor {
+public:
+   RuntimePredictor()          {}
+   void Init(const MachineClasses & machine_classes);
+
+   // Runtime of the task if it started on the host now
+   Time_t Predict(const MachineInfo_t & m_info, const TaskInfo_t & task_info) const;
+   // When the host's tracked tasks are predicted to have finished, 0 if it has none.
+   // Only grows while the host has tasks, so it may be late after early completions.
+   Time_t Drain(MachineId_t machine_id) const {
+      return machine_id < hosts.size() && hosts[machine_id].tasks > 0 ? hosts[machine_id].drain : 0;
+   }
+
+   // Returns the predicted completion time
+   Time_t Started(Time_t now, const MachineInfo_t & m_info, const TaskInfo_t & task_info);
+   void Completed(Time_t now, TaskId_t task_id);
+   // The task's VM migrated; its predicted completion now counts towards the destination
+   void Moved(TaskId_t task_id, MachineId_t destination);
+
+   uint64_t Samples() const    { return samples; }
+   // Mean absolute error of the predictions checked so far, relative to the runtime
+   double MeanError() const    { return samples ? total_error / samples : 0; }
+private:
+   static const unsigned VM_TYPES = 4;
+   static const unsigned SIZES = 8;
+   static const unsigned KINDS = VM_TYPES * 2 * SIZES;
+   static const unsigned WINDOW = 16;  // samples after which the mean turns into a moving average
+
+   struct Slowdown {
+      float mean = 1;
+      unsigned samples = 0;
+      void Add(float observed) {
+         samples++;
+         mean += (observed - mean) / float(samples < WINDOW ? samples : WINDOW);
+      }
+   };
+   struct Running {
+      Time_t start;
+      Time_t predicted;
+      double ideal;            // runtime on an idle host
+      MachineId_t machine_id;
+      uint32_t cell;
+      uint16_t kind;
+   };
+   struct Host {
+      Time_t drain = 0;
+      unsigned tasks = 0;
+   };
+
+   const MachineClasses * machine_classes = nullptr;
+   vector<Slowdown> cells;     // machine class x P-state x kind
+   Slowdown kinds[KINDS];      // across all classes
+   std::unordered_map<TaskId_t, Running> running;   // live tasks only
+   vector<Host> hosts;
+   uint64_t samples = 0;
+   double total_error = 0;
+
+   static unsigned Kind(const TaskInfo_t & task_info);
+   double Ideal(const MachineInfo_t & m_info, const TaskInfo_t & task_info) const;
+   float Factor(uint32_t cell, unsigned kind) const;
+};
+
+
+#endif /* RuntimePredictor_hpp */
@@ -7,11 +7,16 @@
 
 
 #include "Scheduler.hpp"
+#include <algorithm>
 #include <climits>
+#include <cstdlib>
 
 
-static bool migrating = false;
 static unsigned active_machines = 16;
+// How long an empty VM is kept around for reuse before it is shut down
+static const Time_t VM_IDLE_TIMEOUT = 10000000;
+// Default spacing of telemetry samples
+static const Time_t TELEMETRY_PERIOD = 1000000;
 
 
 Priority_t determinePriority(SLAType_t sla) {
@@ -45,16 +50,68 @@ void Scheduler::Init() {
    SimOutput("Scheduler::Init(): Total number of machines is " + to_string(total_machines), 3);
    SimOutput("Scheduler::Init(): Initializing scheduler", 1);
 
+   // Every action taken on the cluster, for comparing runs with decisiondiff
+   const char * decisions_file = getenv("CLOUDSIM_DECISIONS");
+   if (decisions_file != nullptr) {
+      decisions.Open(decisions_file);
+   }
+
+   machine_classes.Init(total_machines);
+   for (unsigned c = 0; c < machine_classes.NumClasses(); c++) {
+       const MachineClass & machine_class = machine_classes.Class(c);
+       best_mips[machine_class.cpu] = max(best_mips[machine_class.cpu], machine_class.mips[P0]);
+   }
+
+   vm_pool.Init(total_machines);
    for (unsigned i = 0; i < total_machines; i++) {
        machines.push_back(i);
-       powered_on.insert(i); // Track that machine is on
-       MachineInfo_t machine_info = Machine_GetInfo(i); 
-       VMId_t vm = VM_Create(GetDefaultVMForCPU(machine_info.cpu), machine_info.cpu);
+       powered_on.Insert(i); // Track that machine is on
+       CPUType_t cpu = machine_classes.OfMachine(i).cpu;
+       VMId_t vm = VM_Create(GetDefaultVMForCPU(cpu), cpu);
        VM_Attach(vm, i);
+       decisions.Record(Now(), DECISION_VM_CREATE, vm, GetDefaultVMForCPU(cpu), cpu);
+       decisions.Record(Now(), DECISION_VM_ATTACH, vm, i);
 
 
        vms.push_back(vm);
-       vm_to_machine[vm] = i;
+       machine_vms.Append(i, vm);
+       vm_pool.Track(0, vm, i, GetDefaultVMForCPU(cpu));
+   }
+   memory_index.Init(total_machines);
+   scorer.Init(machine_classes);
+   runtimes.Init(machine_classes);
+   preemption.Init(machine_vms);
+   timeline.Init(total_machines);
+   changes.Subscribe(this);
+   // Rack layout, if any; the input file itself may be given, since it can carry rack classes
+   const char * topology_file = getenv("CLOUDSIM_TOPOLOGY");
+   if (topology_file != nullptr) {
+      topology.Load(topology_file, total_machines);
+      changes.Subscribe(&topology);
+   }
+   changes.Init(total_machines);
+
+   // Time series of every machine, sampled from the timer callback
+   const char * telemetry_file = getenv("CLOUDSIM_TELEMETRY");
+   if (telemetry_file != nullptr) {
+      const char * period = getenv("CLOUDSIM_TELEMETRY_PERIOD");
+      telemetry.Open(telemetry_file, period != nullptr ? strtoull(period, nullptr, 10) : TELEMETRY_PERIOD, changes,
+                     machine_classes);
+   }
+
+   // Learned placement, trained online and kept in the given file between runs
+   const char * model_path = getenv("CLOUDSIM_MODEL");
+   if (model_path != nullptr) {
+      double max_score = 0;
+      for (unsigned c = 0; c < machine_classes.NumClasses(); c++) {
+         for (unsigned p = 0; p < P_STATES; p++) {
+            max_score = max(max_score, scorer.Class(c).energy_per_instruction[p]);
+         }
+      }
+      learning = true;
+      model_file = model_path;
+      model.Init(max_score);
+      model.Load(model_file);
    }
 
    SimOutput("Scheduler::Init(): Initialized " + to_string(active_machines) + " X86 machines with VMs.", 3);
@@ -62,81 +119,433 @@ void Scheduler::Init() {
 }
 
 
+VMId_t Scheduler::AcquireVM(const TaskInfo_t & task_info, MachineId_t machine_id) {
+   bool created;
+   VMId_t vm = vm_pool.Acquire(machine_id, task_info.required_vm, task_info.required_cpu, created);
+   if (created) {
+      decisions.Record(Now(), DECISION_VM_CREATE, vm, task_info.required_vm, task_info.required_cpu);
+      decisions.Record(Now(), DECISION_VM_ATTACH, vm, machine_id);
+      vms.push_back(vm);
+      machine_vms.Append(machine_id, vm);
+   }
+   return vm;
+}
+
+
+void Scheduler::RetireIdleVMs(Time_t now) {
+   vector<VMId_t> retired;
+   vm_pool.Retire(now, VM_IDLE_TIMEOUT, retired);
+   if (retired.empty()) return;
+
+   std::sort(retired.begin(), retired.end());
+   vms.erase(std::remove_if(vms.begin(), vms.end(), [&](VMId_t vm) {
+      return std::binary_search(retired.begin(), retired.end(), vm);
+   }), vms.end());
+
+   for (VMId_t vm : retired) {
+      decisions.Record(now, DECISION_VM_SHUTDOWN, vm);
+      MachineId_t machine_id = machine_vms.OwnerOf(vm);
+      machine_vms.Remove(vm);
+      memory_index.Update(machine_id);
+      timeline.Update(machine_id);
+      changes.Refresh(now, machine_id);
+   }
+   SimOutput("RetireIdleVMs(): Shut down " + to_string(retired.size()) + " idle VMs, " + to_string(vm_pool.Live()) + " left", 3);
+}
+
+
+void Scheduler::MemoryOverflow(Time_t now, MachineId_t machine_id) {
+   MachineInfo_t m_info = Machine_GetInfo(machine_id);
+   memory_index.Update(machine_id);
+   timeline.Update(machine_id);
+   if (m_info.memory_used <= m_info.memory_size) return;
+   unsigned overflow = m_info.memory_used - m_info.memory_size;
+
+   // Rank the VMs on the machine: best-effort work goes first, then the biggest footprint.
+   // A VM is only as expendable as the most demanding task it hosts.
+   struct Victim {
+      VMId_t vm;
+      unsigned footprint;
+      unsigned sla;
+   };
+   vector<Victim> victims;
+   for (VMId_t vm : machine_vms.Of(machine_id)) {
+      if (migrating_vms.Contains(vm)) continue;
+      VMInfo_t vm_info = VM_GetInfo(vm);
+      if (vm_info.active_tasks.empty()) continue;
+
+      Victim victim = {vm, VM_MEMORY_OVERHEAD, SLA3};
+      for (TaskId_t task : vm_info.active_tasks) {
+         victim.footprint += GetTaskMemory(task);
+         victim.sla = min(victim.sla, unsigned(RequiredSLA(task)));
+      }
+      victims.push_back(victim);
+   }
+   std::sort(victims.begin(), victims.end(), [](const Victim & a, const Victim & b) {
+      return a.sla != b.sla ? a.sla > b.sla : a.footprint > b.footprint;
+   });
+
+   // Migrations are asynchronous, so nothing here waits: the VMs are only
+   // marked as in flight and NewTask() keeps placing around them.
+   unsigned relieved = 0;
+   for (const Victim & victim : victims) {
+      if (relieved >= overflow) break;
+
+      MachineId_t host;
+      if (memory_index.FindHost(Machine_GetCPUType(machine_id), victim.footprint, machine_id, powered_on, host)) {
+         memory_index.Reserve(host, victim.vm, victim.footprint);
+         Relocate(victim.vm, host);
+         relieved += victim.footprint;
+         SimOutput("MemoryOverflow(): Migrating VM " + to_string(victim.vm) + " (" + to_string(victim.footprint) +
+                   " MB) from machine " + to_string(machine_id) + " to " + to_string(host), 2);
+         continue;
+      }
+
+      // Nowhere to go: let the best-effort tasks yield to everybody else on the machine
+      for (TaskId_t task : VM_GetInfo(victim.vm).active_tasks) {
+         if (RequiredSLA(task) == SLA3) {
+            preemption.Pin(task);
+            SetTaskPriority(task, LOW_PRIORITY);
+            decisions.Record(Now(), DECISION_SET_TASK_PRIORITY, task, LOW_PRIORITY);
+         }
+      }
+      SimOutput("MemoryOverflow(): No host for VM " + to_string(victim.vm) + ", deprioritised its SLA3 tasks", 2);
+   }
+}
+
+
 void Scheduler::MigrationComplete(Time_t time, VMId_t vm_id) {
-   // Update your data structure. The VM now can receive new tasks
+   // The destination is charged for the VM from now on, and the plan that moved it resumes
+   memory_index.Arrived(vm_id);
+   async.Migrated(time, vm_id);
+}
+
+
+// Moves a VM off an overcommitted machine; NewTask() places around it until it has arrived
+Plan Scheduler::Relocate(VMId_t vm_id, MachineId_t destination) {
+   MachineId_t source = machine_vms.OwnerOf(vm_id);
+   migrating_vms.Insert(vm_id);
+   decisions.Record(Now(), DECISION_VM_MIGRATE, vm_id, destination);
+   Time_t time = co_await async.Migrate(vm_id, destination);
+
+   // The VM now can receive new tasks, and its tasks count towards the destination
+   migrating_vms.Erase(vm_id);
+   machine_vms.Append(destination, vm_id);
+   vm_pool.Moved(vm_id, destination);
+   for (TaskId_t task_id : VM_GetInfo(vm_id).active_tasks) {
+      runtimes.Moved(task_id, destination);
+      timeline.Moved(task_id, destination);
+   }
+   memory_index.Update(source);
+   memory_index.Update(destination);
+   timeline.Update(source);
+   timeline.Update(destination);
+   changes.Refresh(time, source);
+   changes.Refresh(time, destination);
+   YieldCores(time, source);
+   YieldCores(time, destination);
+   DrainPending(source);
 }
 
 
 void Scheduler::NewTask(Time_t now, TaskId_t task_id) {
    TaskInfo_t task_info = GetTaskInfo(task_id);
    VMId_t best_vm = -1;
-   int min_tasks = UINT_MAX;
-
-   // Step 1: Check the VM's on active machines
+   unsigned min_tasks = UINT_MAX;
+   bool best_on_time = false;
+   unsigned best_packed = 0;
+   double best_score = 0;
+   Time_t best_extension = 0;
+   // With the learned model, hosts that can meet the deadline still come first
+   // and the predicted cost replaces the rest of the ranking
+   bool explore = learning && model.Explore();
+   float best_cost = 0;
+   PlacementFeatures best_features = {};
+
+   // Step 1: Check the VM's on active machines. Hosts that can still meet the
+   // deadline win, then hosts in the rack with the most machines awake (so load
+   // packs into few racks), then the cheapest energy per instruction, then the
+   // host whose busy time the task extends least (so tasks that finish together
+   // share a host, which can then sleep sooner), then the least loaded VM.
    for (VMId_t vm : vms) {
       VMInfo_t vm_info = VM_GetInfo(vm);
       MachineId_t machine_id = vm_info.machine_id;
       MachineInfo_t m_info = Machine_GetInfo(machine_id);
 
-      if (m_info.s_state != S0) continue; // checks if machine is active
+      if (m_info.s_state != S0 || !powered_on.Contains(machine_id)) continue; // checks if machine is active
+      if (migrating_vms.Contains(vm)) continue;
       if (m_info.cpu != task_info.required_cpu || vm_info.vm_type != task_info.required_vm) continue;
 
       unsigned available_memory = m_info.memory_size - m_info.memory_used;
-      if (available_memory < task_info.required_memory + VM_MEMORY_OVERHEAD) continue;
-
-      if (vm_info.active_tasks.size() < min_tasks) {
+      if (available_memory < task_info.required_memory + VM_MEMORY_OVERHEAD + timeline.Reserved(machine_id)) continue;
+
+      bool on_time = scorer.MeetsDeadline(m_info, task_info, now);
+      double score = scorer.Score(m_info);
+      unsigned load = unsigned(vm_info.active_tasks.size());
+      unsigned packed = topology.AwakeInRack(machine_id);
+      Time_t extension = Extension(m_info, task_info, now);
+      if (learning) {
+         PlacementFeatures features = model.Features(m_info, task_info, score, on_time, load, packed, false);
+         float cost = explore ? model.Noise() : model.Predict(features);
+         if (best_vm == VMId_t(-1) || on_time > best_on_time || (on_time == best_on_time && cost < best_cost)) {
+            best_vm = vm;
+            best_on_time = on_time;
+            best_cost = cost;
+            best_features = features;
+         }
+         continue;
+      }
+      if (best_vm == VMId_t(-1) || on_time > best_on_time ||
+          (on_time == best_on_time && (packed > best_packed ||
+          (packed == best_packed && (score < best_score || (score == best_score && (extension < best_extension ||
+          (extension == best_extension && load < min_tasks)))))))) {
          best_vm = vm;
-         min_tasks = vm_info.active_tasks.size();
+         min_tasks = load;
+         best_on_time = on_time;
+         best_packed = packed;
+         best_score = score;
+         best_extension = extension;
       }
    }
 
    if (best_vm != VMId_t(-1)) {
        VM_AddTask(best_vm, task_id, task_info.priority);
+       decisions.Record(now, DECISION_VM_ADD_TASK, best_vm, task_id, task_info.priority);
+       tasks.Insert(task_info, best_vm);
+       MachineId_t host = machine_vms.OwnerOf(best_vm);
+       Time_t finish = runtimes.Started(now, Machine_GetInfo(host), task_info);
+       memory_index.Update(host);
+       timeline.Started(host, task_id, task_info.required_memory, finish);
+       changes.RefreshVM(now, best_vm, host);
+       preemption.Started(best_vm, task_info);
+       YieldCores(now, host);
+       if (learning) model.Placed(task_id, host, best_features);
        SimOutput("NewTask(): Assigned to existing VM " + to_string(best_vm), 2);
        return;
    }
 
 
-   // Step 2: Create a new VM on an active machine
+   // Step 2: Create a new VM on the most efficient active machine that has room
+   MachineId_t best_machine = MachineId_t(-1);
    for (unsigned i = 0; i < machines.size(); i++) {
       MachineId_t machine_id = machines[i];
       MachineInfo_t m_info = Machine_GetInfo(machine_id);
 
-      if (m_info.s_state != S0 || m_info.cpu != task_info.required_cpu) continue;
+      if (m_info.s_state != S0 || !powered_on.Contains(machine_id) || m_info.cpu != task_info.required_cpu) continue;
       unsigned available_memory = m_info.memory_size - m_info.memory_used;
-      if (available_memory < task_info.required_memory + VM_MEMORY_OVERHEAD) continue;
+      if (available_memory < task_info.required_memory + VM_MEMORY_OVERHEAD + timeline.Reserved(machine_id)) continue;
+
+      bool on_time = scorer.MeetsDeadline(m_info, task_info, now);
+      double score = scorer.Score(m_info);
+      unsigned packed = topology.AwakeInRack(machine_id);
+      Time_t extension = Extension(m_info, task_info, now);
+      if (learning) {
+         PlacementFeatures features = model.Features(m_info, task_info, score, on_time, 0, packed, true);
+         float cost = explore ? model.Noise() : model.Predict(features);
+         if (best_machine == MachineId_t(-1) || on_time > best_on_time || (on_time == best_on_time && cost < best_cost)) {
+            best_machine = machine_id;
+            best_on_time = on_time;
+            best_cost = cost;
+            best_features = features;
+         }
+         continue;
+      }
+      if (best_machine == MachineId_t(-1) || on_time > best_on_time ||
+          (on_time == best_on_time && (packed > best_packed || (packed == best_packed && (score < best_score ||
+          (score == best_score && extension < best_extension)))))) {
+         best_machine = machine_id;
+         best_on_time = on_time;
+         best_packed = packed;
+         best_score = score;
+         best_extension = extension;
+      }
+   }
+
+   if (best_machine != MachineId_t(-1)) {
+      MachineId_t machine_id = best_machine;
 
       // Create VM and defer task assignment 
       
-      VMId_t new_vm = VM_Create(task_info.required_vm, task_info.required_cpu);
-      VM_Attach(new_vm, machine_id);
+      VMId_t new_vm = AcquireVM(task_info, machine_id);
+      Time_t finish = runtimes.Started(now, Machine_GetInfo(machine_id), task_info);
       VM_AddTask(new_vm, task_id, task_info.priority);
-      vms.push_back(new_vm);
+      decisions.Record(now, DECISION_VM_ADD_TASK, new_vm, task_id, task_info.priority);
+      tasks.Insert(task_info, new_vm);
+      memory_index.Update(machine_id);
+      timeline.Started(machine_id, task_id, task_info.required_memory, finish);
+      changes.RefreshVM(now, new_vm, machine_id);
+      preemption.Started(new_vm, task_info);
+      YieldCores(now, machine_id);
+      if (learning) model.Placed(task_id, machine_id, best_features);
   
       SimOutput("NewTask(): Created VM " + to_string(new_vm) + " on machine " + to_string(machine_id) + " — task deferred", 2);
       return;
    }
 
-   // Step 3: Activate a new machine and create a new VM
-   for (unsigned i = 0; i < Machine_GetTotal(); i++) {
-      MachineId_t machine = MachineId_t(i);
-      MachineInfo_t m_info = Machine_GetInfo(machine);
-      if (m_info.s_state == S5 && m_info.cpu == task_info.required_cpu) {
-         Machine_SetState(machine, S0);
-         VMId_t new_vm = VM_Create(task_info.required_vm, task_info.required_cpu);
-         SimOutput("went wrong at this attach", 3);
-         VM_Attach(new_vm, machine);
-         VM_AddTask(new_vm, task_id, task_info.priority);
-
-         vms.push_back(new_vm);
-         machines.push_back(machine);
-
-         SimOutput("NewTask(): Powered on sleeping machine " + to_string(machine) + " for task " + to_string(task_id), 2);
+   // Step 3: Activate the sleeping machine of the most efficient class. A VM
+   // cannot be attached until the machine is up, so the task waits in the
+   // admission queue and StateChangeComplete() places it. Machines already
+   // waking up take further tasks while their memory lasts.
+   unsigned needed = task_info.required_memory + VM_MEMORY_OVERHEAD;
+   for (MachineId_t waking_machine : waking.Keys()) {
+      unsigned & unpromised = waking.Get(waking_machine);
+      if (Machine_GetCPUType(waking_machine) == task_info.required_cpu && unpromised >= needed) {
+         unpromised -= needed;
+         pending_tasks.Push(task_info, LatestStart(task_info));
+         SimOutput("NewTask(): Task " + to_string(task_id) + " waits for machine " + to_string(waking_machine) + " to wake up", 2);
+         return;
+      }
+   }
+
+   // Tasks that can afford to wait take memory a running machine is about to
+   // give back, instead of waking a machine of their own. They do not jump
+   // ahead of queued tasks that hold nothing, which would then wait for them.
+   if (task_info.required_sla >= SLA2 && pending_tasks.Size() == timeline.Reservations()) {
+      Time_t ready;
+      MachineId_t host;
+      if (timeline.Earliest(task_info.required_cpu, needed, powered_on, ready, host) && ready <= LatestStart(task_info)) {
+         timeline.Reserve(host, task_id, needed);
+         pending_tasks.Push(task_info, LatestStart(task_info));
+         SimOutput("NewTask(): Task " + to_string(task_id) + " reserved memory on machine " + to_string(host) +
+                   " from " + to_string(ready), 2);
          return;
       }
    }
 
-   SimOutput("NewTask(): No placement found for task " + to_string(task_id), 1);
+   MachineId_t machine = MachineId_t(-1);
+   for (unsigned i = 0; i < Machine_GetTotal(); i++) {
+      MachineInfo_t m_info = Machine_GetInfo(MachineId_t(i));
+      if (m_info.s_state != S5 || m_info.cpu != task_info.required_cpu) continue;
+      if (waking.Contains(MachineId_t(i)) || m_info.memory_size < needed) continue;
+
+      // A machine in a dark rack also switches on the rack's static power
+      unsigned mips = machine_classes.OfMachine(MachineId_t(i)).mips[P0];
+      double score = scorer.Score(m_info) + double(topology.WakePower(MachineId_t(i))) / mips;
+      if (machine == MachineId_t(-1) || score < best_score) {
+         machine = MachineId_t(i);
+         best_score = score;
+      }
+   }
+
+   if (machine != MachineId_t(-1)) {
+      PowerOnFor(machine, task_id);
+      return;
+   }
+
+   // Nothing can take the task right now, hold it until capacity frees up
+   pending_tasks.Push(task_info, LatestStart(task_info));
+   SimOutput("NewTask(): No placement found for task " + to_string(task_id) + ", queued for admission", 2);
+}
+
+
+// Wakes a sleeping machine for a task. A VM cannot be attached until the
+// machine is up, so the task waits in the admission queue meanwhile, and
+// StateChangeComplete() has placed it by the time this plan resumes.
+Plan Scheduler::PowerOnFor(MachineId_t machine_id, TaskId_t task_id) {
+   TaskInfo_t task_info = GetTaskInfo(task_id);
+   decisions.Record(Now(), DECISION_MACHINE_SET_STATE, machine_id, S0);
+   powered_on.Insert(machine_id);
+   waking[machine_id] = Machine_GetInfo(machine_id).memory_size - (task_info.required_memory + VM_MEMORY_OVERHEAD);
+   pending_tasks.Push(task_info, LatestStart(task_info));
+   SimOutput("PowerOnFor(): Powering on sleeping machine " + to_string(machine_id) + " for task " + to_string(task_id), 2);
+
+   Time_t time = co_await async.WakeMachine(machine_id);
+   SimOutput("PowerOnFor(): Machine " + to_string(machine_id) + " is up at " + to_string(time), 3);
+}
+
+
+Time_t Scheduler::LatestStart(const TaskInfo_t & task_info) {
+   // MIPS is instructions per microsecond, so this is the runtime on the fastest machine at P0
+   unsigned mips = max(best_mips[task_info.required_cpu], 1u);
+   Time_t runtime = task_info.total_instructions / mips;
+   return task_info.target_completion > runtime ? task_info.target_completion - runtime : 0;
+}
+
+
+// How much later the host would drain if the task started on it now. A task
+// that has to share a core stretches everybody on the host, so hosts without
+// a free core come last.
+Time_t Scheduler::Extension(const MachineInfo_t & m_info, const TaskInfo_t & task_info, Time_t now) const {
+   if (m_info.active_tasks >= machine_classes.OfMachine(m_info.machine_id).num_cpus) return Time_t(-1);
+   Time_t finish = now + runtimes.Predict(m_info, task_info);
+   Time_t drain = max(runtimes.Drain(m_info.machine_id), now);
+   return finish > drain ? finish - drain : 0;
+}
+
+
+// Suspends the host's SLA3 tasks while urgent work oversubscribes its cores, and resumes them after
+void Scheduler::YieldCores(Time_t now, MachineId_t machine_id) {
+   vector<std::pair<TaskId_t, Priority_t>> priorities;
+   preemption.Update(machine_id, machine_classes.OfMachine(machine_id).num_cpus,
+                     Machine_GetInfo(machine_id).active_tasks, priorities);
+   for (const auto & change : priorities) {
+      SetTaskPriority(change.first, change.second);
+      decisions.Record(now, DECISION_SET_TASK_PRIORITY, change.first, change.second);
+   }
+}
+
+
+bool Scheduler::PlaceOnMachine(const TaskInfo_t & task_info, MachineId_t machine_id) {
+   MachineInfo_t m_info = Machine_GetInfo(machine_id);
+   if (m_info.s_state != S0 || !powered_on.Contains(machine_id) || m_info.cpu != task_info.required_cpu) return false;
+   // Memory reserved for other queued tasks is not free for this one
+   unsigned reserved = timeline.Reserved(machine_id) - timeline.Held(machine_id, task_info.task_id);
+   if (m_info.memory_used + task_info.required_memory + VM_MEMORY_OVERHEAD + reserved > m_info.memory_size) return false;
+
+   VMId_t vm = VMId_t(-1);
+   for (VMId_t candidate : machine_vms.Of(machine_id)) {
+      if (migrating_vms.Contains(candidate)) continue;
+      if (VM_GetInfo(candidate).vm_type == task_info.required_vm) {
+         vm = candidate;
+         break;
+      }
+   }
+   if (vm == VMId_t(-1)) {
+      vm = AcquireVM(task_info, machine_id);
+   }
+
+   Time_t finish = runtimes.Started(Now(), m_info, task_info);
+   VM_AddTask(vm, task_info.task_id, task_info.priority);
+   decisions.Record(Now(), DECISION_VM_ADD_TASK, vm, task_info.task_id, task_info.priority);
+   tasks.Insert(task_info, vm);
+   memory_index.Update(machine_id);
+   timeline.Fulfil(task_info.task_id);
+   timeline.Started(machine_id, task_info.task_id, task_info.required_memory, finish);
+   changes.RefreshVM(Now(), vm, machine_id);
+   preemption.Started(vm, task_info);
+   YieldCores(Now(), machine_id);
+   return true;
+}
+
+
+void Scheduler::DrainPending(MachineId_t machine_id) {
+   CPUType_t cpu = Machine_GetCPUType(machine_id);
+   if (pending_tasks.Empty(cpu) || !powered_on.Contains(machine_id)) return;
+
+   memory_index.Update(machine_id);
+   if (!memory_index.IsIndexed(machine_id)) return;
+
+   // Only fill idle cores: the simulator aborts when a completion callback adds a
+   // task to a core that is already busy. Memory reserved here is free only for the
+   // tasks holding it; the others are set aside until the next drain.
+   PendingTask task;
+   vector<PendingTask> set_aside;
+   while (Machine_GetInfo(machine_id).active_tasks < Machine_GetInfo(machine_id).num_cpus &&
+          pending_tasks.PopFitting(cpu, memory_index.FreeMemory(machine_id), task)) {
+      unsigned reserved = timeline.Reserved(machine_id) - timeline.Held(machine_id, task.task_id);
+      if (task.needed + reserved > memory_index.FreeMemory(machine_id)) {
+         set_aside.push_back(task);
+         continue;
+      }
+      if (!PlaceOnMachine(GetTaskInfo(task.task_id), machine_id)) {
+         pending_tasks.Push(cpu, task);
+         break;
+      }
+      SimOutput("DrainPending(): Admitted queued task " + to_string(task.task_id) + " on machine " + to_string(machine_id), 2);
+   }
+   for (const PendingTask & other : set_aside) {
+      pending_tasks.Push(cpu, other);
+   }
 }
 
 
@@ -145,11 +554,24 @@ void Scheduler::PeriodicCheck(Time_t now) {
    // SchedulerCheck is called periodically by the simulator to allow you to monitor, make decisions, adjustments, etc.
    // Unlike the other invocations of the scheduler, this one doesn't report any specific event
    // Recommendation: Take advantage of this function to do some monitoring and adjustments as necessary
-   for (MachineId_t machine : machines) {
-       MachineInfo_t machine_info = Machine_GetInfo(machine);
-       if (machine_info.active_tasks == 0 && machine_info.active_vms == 0 && machine_info.s_state == S0) {
-           Machine_SetState(machine, S5);
+   telemetry.Sample(now);
+   RetireIdleVMs(now);
+
+   // Only machines the change feed reported idle are looked at, not the whole cluster
+   IdSet<MachineId_t> idle;
+   idle.Swap(idle_machines);
+   for (MachineId_t machine : idle) {
+       // A VM on its way here could not attach to a sleeping machine, and queued
+       // tasks holding memory here would lose it
+       if (memory_index.Reserved(machine) > 0 || timeline.Reserved(machine) > 0) {
+           idle_machines.Insert(machine);
+           continue;
        }
+       Machine_SetState(machine, S5);
+       decisions.Record(now, DECISION_MACHINE_SET_STATE, machine, S5);
+       powered_on.Erase(machine);
+       memory_index.Remove(machine);
+       timeline.Remove(machine);
    }
 }
 
@@ -160,7 +582,10 @@ void Scheduler::Shutdown(Time_t time) {
    // Report about the SLA compliance
    // Shutdown everything to be tidy :-)
    for(auto & vm: vms) {
+       // VMs on sleeping machines cannot be detached and go down with the machine
+       if (Machine_GetInfo(machine_vms.OwnerOf(vm)).s_state != S0) continue;
        VM_Shutdown(vm);
+       decisions.Record(time, DECISION_VM_SHUTDOWN, vm);
    }
    SimOutput("SimulationComplete(): Finished!", 4);
    SimOutput("SimulationComplete(): Time is " + to_string(time), 4);
@@ -169,6 +594,45 @@ void Scheduler::Shutdown(Time_t time) {
    SimOutput("SLA1: " + to_string(GetSLAReport(SLA1)) + "%", 1);
    SimOutput("SLA2: " + to_string(GetSLAReport(SLA2)) + "%", 1);
    SimOutput("SLA3: best-effort", 1);
+
+   for (unsigned sla = SLA0; sla < NUM_SLAS; sla++) {
+       const TaskSummary & stats = tasks.Summary(SLAType_t(sla));
+       if (stats.completed == 0) continue;
+       SimOutput("SLA" + to_string(sla) + ": " + to_string(stats.completed) + " tasks completed, " +
+                 to_string(stats.violations) + " violations, mean turnaround " +
+                 to_string(stats.total_turnaround / stats.completed) + " us", 1);
+   }
+   if (topology.Enabled()) {
+       for (unsigned rack = 0; rack < topology.NumRacks(); rack++) {
+           SimOutput("Rack " + to_string(rack) + ": " + to_string(topology.RackEnergy(rack, time)) + " KW-Hour", 2);
+       }
+       double rack_energy = topology.TotalEnergy(time);
+       SimOutput("Rack overhead: " + to_string(rack_energy) + " KW-Hour", 1);
+       SimOutput("Total Energy with racks: " + to_string(Machine_GetClusterEnergy() + rack_energy) + " KW-Hour", 1);
+   }
+   if (learning) {
+       model.Save(model_file);
+       SimOutput("Placement model: " + to_string(model.Updates()) + " updates, mean absolute error " +
+                 to_string(model.MeanError()) + ", saved to " + model_file, 1);
+   }
+   SimOutput("Runtime predictor: " + to_string(runtimes.Samples()) + " completions, mean relative error " +
+             to_string(runtimes.MeanError()), 1);
+   SimOutput("Preemption: " + to_string(preemption.Suspensions()) + " SLA3 task suspensions, " +
+             to_string(preemption.Resumptions()) + " resumed", 1);
+   SimOutput("Admission queue: " + to_string(pending_tasks.Size()) + " tasks never admitted, " +
+             to_string(timeline.Fulfilled()) + " placed on memory reserved for them", 1);
+   SimOutput("VM pool: " + to_string(vm_pool.Live()) + " live VMs, peak " + to_string(vm_pool.Peak()) +
+             ", " + to_string(vm_pool.Reused()) + " reused", 1);
+   SimOutput("Task table: " + to_string(tasks.Live()) + " live tasks in " + to_string(tasks.Capacity()) + " slots", 2);
+   if (telemetry.Enabled()) {
+       telemetry.Close();
+       SimOutput("Telemetry: " + to_string(telemetry.Samples()) + " samples, " + to_string(telemetry.Stalls()) +
+                 " writer stalls, sampled energy " + to_string(telemetry.SampledEnergy()) + " KW-Hour", 1);
+   }
+   if (decisions.Enabled()) {
+       SimOutput("Decision log: " + to_string(decisions.Records()) + " decisions recorded", 1);
+       decisions.Close();
+   }
 }
 
 
@@ -176,11 +640,41 @@ void Scheduler::TaskComplete(Time_t now, TaskId_t task_id) {
    // Do any bookkeeping necessary for the data structures
    // Decide if a machine is to be turned off, slowed down, or VMs to be migrated according to your policy
    // This is an opportunity to make any adjustments to optimize performance/energy
-  
+   TaskHandle_t handle = tasks.Find(task_id);
+   VMId_t vm_id = handle != INVALID_TASK_HANDLE ? tasks.Get(handle).vm_id : VMId_t(-1);
+   MachineId_t machine_id = vm_id != VMId_t(-1) ? machine_vms.OwnerOf(vm_id) : MachineId_t(-1);
+   tasks.Release(task_id, now);
+   runtimes.Completed(now, task_id);
+   timeline.Completed(task_id);
+   preemption.Completed(task_id);
+   if (machine_id != MachineId_t(-1)) {
+      if (learning) model.Completed(task_id, Machine_GetInfo(machine_id).active_tasks + 1, IsSLAViolation(task_id));
+      memory_index.Update(machine_id);
+      changes.RefreshVM(now, vm_id, machine_id);
+      DrainPending(machine_id);
+      YieldCores(now, machine_id);
+   }
+
    SimOutput("Scheduler::TaskComplete(): Task " + to_string(task_id) + " is complete at " + to_string(now), 4);
 }
 
 
+void Scheduler::SLAWarning(Time_t now, TaskId_t task_id) {
+   SetTaskPriority(task_id, HIGH_PRIORITY);
+   decisions.Record(now, DECISION_SET_TASK_PRIORITY, task_id, HIGH_PRIORITY);
+}
+
+
+void Scheduler::StateChangeComplete(Time_t now, MachineId_t machine_id) {
+   waking.Erase(machine_id);
+   memory_index.Update(machine_id);
+   timeline.Update(machine_id);
+   changes.Refresh(now, machine_id);
+   DrainPending(machine_id);
+   async.StateChanged(now, machine_id);
+}
+
+
 // Public interface below
 
 
@@ -208,6 +702,7 @@ void HandleTaskCompletion(Time_t time, TaskId_t task_id) {
 void MemoryWarning(Time_t time, MachineId_t machine_id) {
    // The simulator is alerting you that machine identified by machine_id is overcommitted
    SimOutput("MemoryWarning(): Overflow at " + to_string(machine_id) + " was detected at time " + to_string(time), 0);
+   Scheduler.MemoryOverflow(time, machine_id);
 }
 
 
@@ -215,7 +710,6 @@ void MigrationDone(Time_t time, VMId_t vm_id) {
    // The function is called on to alert you that migration is complete
    SimOutput("MigrationDone(): Migration of VM " + to_string(vm_id) + " was completed at time " + to_string(time), 4);
    Scheduler.MigrationComplete(time, vm_id);
-   migrating = false;
 }
 
 
@@ -247,13 +741,13 @@ void SimulationComplete(Time_t time) {
 
 
 void SLAWarning(Time_t time, TaskId_t task_id) {
-   SetTaskPriority(task_id, HIGH_PRIORITY);
+   Scheduler.SLAWarning(time, task_id);
 }
 
 
 void StateChangeComplete(Time_t time, MachineId_t machine_id) {
    // Called in response to an earlier request to change the state of a machine
-  
+   Scheduler.StateChangeComplete(time, machine_id);
 }
 
 
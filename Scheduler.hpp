@@ -14,9 +14,23 @@
 #include <queue>
 
 
+#include "AdmissionQueue.hpp"
+#include "Async.hpp"
+#include "CapacityTimeline.hpp"
+#include "ChangeFeed.hpp"
+#include "DecisionLog.hpp"
+#include "DenseId.hpp"
+#include "FreeMemoryIndex.hpp"
 #include "Interfaces.h"
-#include <unordered_map>
-#include <set>
+#include "MachineClasses.hpp"
+#include "PlacementModel.hpp"
+#include "PlacementScorer.hpp"
+#include "Preemption.hpp"
+#include "RuntimePredictor.hpp"
+#include "TaskTable.hpp"
+#include "Telemetry.hpp"
+#include "Topology.hpp"
+#include "VMPool.hpp"
 
 
 struct CompareMachineEnergy {
@@ -26,16 +40,23 @@ struct CompareMachineEnergy {
 };
 
 
-class Scheduler {
+class Scheduler : public ChangeListener {
 public:
    Scheduler()                 {}
    void Init();
+   void MemoryOverflow(Time_t now, MachineId_t machine_id);
    void MigrationComplete(Time_t time, VMId_t vm_id);
    void NewTask(Time_t now, TaskId_t task_id);
    void PeriodicCheck(Time_t now);
    void Shutdown(Time_t now);
    void TaskComplete(Time_t now, TaskId_t task_id);
    void StateChangeComplete(Time_t now, MachineId_t machine_id);
+   void SLAWarning(Time_t now, TaskId_t task_id);
+
+   void MachineIdle(Time_t now, MachineId_t machine_id) override   { idle_machines.Insert(machine_id); }
+   void MachineBusy(Time_t now, MachineId_t machine_id) override   { idle_machines.Erase(machine_id); }
+   void VMEmptied(Time_t now, VMId_t vm_id, MachineId_t machine_id) override    { vm_pool.MarkIdle(now, vm_id); }
+   void VMOccupied(Time_t now, VMId_t vm_id, MachineId_t machine_id) override   { vm_pool.MarkBusy(vm_id); }
 private:
    vector<VMId_t> vms;
    vector<MachineId_t> machines;
@@ -48,16 +69,43 @@ private:
     CompareMachineEnergy              // Comparator
    > machineQueue; 
 
-   vector<VMId_t> pending_vms; 
+   IdSet<VMId_t> pending_vms; 
    
 
 
-   //needed AI to see how to declare a hashmap in C++ 
-   std::unordered_map<VMId_t, MachineId_t> vm_to_machine;
-   std::unordered_map<MachineId_t, std::vector<VMId_t>> machinesToVMs;
-   std::unordered_map<TaskId_t, VMId_t> task_to_vm;
-   std::set<MachineId_t> powered_on;
+   IdLists<MachineId_t, VMId_t> machine_vms;    // VMs of each machine, and the machine of each VM
+   TaskTable tasks;             // live tasks only, completed ones are summarised
+   IdSet<MachineId_t> powered_on;          // last state asked for was S0; a machine going down still reports S0 for a while
+   IdSet<VMId_t> migrating_vms;
+   FreeMemoryIndex memory_index;
+   ChangeFeed changes;
+   IdSet<MachineId_t> idle_machines;        // kept current by `changes`
+   VMPool vm_pool;
+   Topology topology;
+   PlacementModel model;
+   bool learning = false;
+   string model_file;
+   IdMap<MachineId_t, unsigned> waking;     // memory not yet promised to queued tasks
+   AdmissionQueue pending_tasks;
+   MachineClasses machine_classes;
+   PlacementScorer scorer;
+   RuntimePredictor runtimes;   // learned at every completion, ranks hosts by when they drain
+   CapacityTimeline timeline;   // when memory frees up on each machine, and what queued tasks hold
+   Preemption preemption;       // SLA3 tasks suspended while urgent work shares their cores
+   unsigned best_mips[NUM_CPU_TYPES] = {};
+   DecisionLog decisions;       // off unless CLOUDSIM_DECISIONS names a file
+   Telemetry telemetry;         // off unless CLOUDSIM_TELEMETRY names a file
+   AsyncOps async;              // plans waiting on state changes and migrations; destroyed first
    VMType_t GetDefaultVMForCPU(CPUType_t cpu_type);
+   VMId_t AcquireVM(const TaskInfo_t & task_info, MachineId_t machine_id);
+   void RetireIdleVMs(Time_t now);
+   bool PlaceOnMachine(const TaskInfo_t & task_info, MachineId_t machine_id);
+   void DrainPending(MachineId_t machine_id);
+   Time_t LatestStart(const TaskInfo_t & task_info);
+   Time_t Extension(const MachineInfo_t & m_info, const TaskInfo_t & task_info, Time_t now) const;
+   void YieldCores(Time_t now, MachineId_t machine_id);
+   Plan Relocate(VMId_t vm_id, MachineId_t destination);
+   Plan PowerOnFor(MachineId_t machine_id, TaskId_t task_id);
    
 
 };
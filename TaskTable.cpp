@@ -0,0 +1,108 @@
+//
+//  TaskTable.cpp
+//  CloudSim
+//
+
+
+#include "TaskTable.hpp"
+
+
+static_assert(sizeof(TaskRecord) <= 32, "TaskRecord should stay within half a cache line");
+
+
+static inline uint32_t HandleSlot(TaskHandle_t handle)          { return uint32_t(handle); }
+static inline uint32_t HandleGeneration(TaskHandle_t handle)    { return uint32_t(handle >> 32); }
+static inline TaskHandle_t MakeHandle(uint32_t slot, uint32_t generation) {
+   return (TaskHandle_t(generation) << 32) | slot;
+}
+
+
+TaskHandle_t TaskTable::Insert(const TaskInfo_t & task_info, VMId_t vm_id) {
+   auto it = index.find(task_info.task_id);
+   if (it != index.end()) {
+      // The task is already tracked (e.g. it was re-placed), just update it
+      Get(it->second).vm_id = vm_id;
+      return it->second;
+   }
+
+   if (free_slots.empty()) {
+      uint32_t base = uint32_t(slabs.size() * SLAB_SIZE);
+      slabs.emplace_back(new TaskRecord[SLAB_SIZE]);
+      generations.resize(base + SLAB_SIZE, 0);
+      // Hand out the lowest slots first so live records stay packed together
+      for (uint32_t slot = base + SLAB_SIZE; slot > base; slot--) {
+         free_slots.push_back(slot - 1);
+      }
+   }
+
+   uint32_t slot = free_slots.back();
+   free_slots.pop_back();
+
+   TaskRecord & record = Slot(slot);
+   record.arrival = task_info.arrival;
+   record.target_completion = task_info.target_completion;
+   record.vm_id = vm_id;
+   record.task_id = task_info.task_id;
+   record.memory = task_info.required_memory;
+   record.sla = uint8_t(task_info.required_sla);
+   record.vm_type = uint8_t(task_info.required_vm);
+   record.cpu = uint8_t(task_info.required_cpu);
+   record.priority = uint8_t(task_info.priority);
+
+   TaskHandle_t handle = MakeHandle(slot, generations[slot]);
+   index[task_info.task_id] = handle;
+   return handle;
+}
+
+
+void TaskTable::Release(TaskId_t task_id, Time_t now) {
+   auto it = index.find(task_id);
+   if (it == index.end()) {
+      SimOutput("TaskTable::Release(): Task " + to_string(task_id) + " is not tracked", 2);
+      return;
+   }
+
+   uint32_t slot = HandleSlot(it->second);
+   TaskRecord & record = Slot(slot);
+
+   TaskSummary & stats = summary[record.sla];
+   stats.completed++;
+   if (IsSLAViolation(task_id)) {
+      stats.violations++;
+   }
+   stats.total_turnaround += now - record.arrival;
+
+   // Bumping the generation invalidates every outstanding handle to this slot
+   generations[slot]++;
+   free_slots.push_back(slot);
+   index.erase(it);
+}
+
+
+TaskHandle_t TaskTable::Find(TaskId_t task_id) const {
+   auto it = index.find(task_id);
+   return it == index.end() ? INVALID_TASK_HANDLE : it->second;
+}
+
+
+bool TaskTable::IsValid(TaskHandle_t handle) const {
+   if (handle == INVALID_TASK_HANDLE) return false;
+   uint32_t slot = HandleSlot(handle);
+   return slot < generations.size() && generations[slot] == HandleGeneration(handle);
+}
+
+
+TaskRecord & TaskTable::Get(TaskHandle_t handle) {
+   if (!IsValid(handle)) {
+      ThrowException("TaskTable::Get(): Stale or invalid task handle", unsigned(HandleSlot(handle)));
+   }
+   return Slot(HandleSlot(handle));
+}
+
+
+const TaskRecord & TaskTable::Get(TaskHandle_t handle) const {
+   if (!IsValid(handle)) {
+      ThrowException("TaskTable::Get(): Stale or invalid task handle", unsigned(HandleSlot(handle)));
+   }
+   return Slot(HandleSlot(handle));
+}
@@ -0,0 +1,87 @@
+//
+//  TaskTable.hpp
+//  CloudSim
+//
+//  Compact, slab-allocated store for the tasks the scheduler is tracking.
+//  Records only live while a task is running; completed tasks are folded
+//  into per-SLA counters and their slots are handed out again.
+//
+
+
+#ifndef TaskTable_hpp
+#define TaskTable_hpp
+
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "Interfaces.h"
+
+
+// Slot index in the low 32 bits, generation of the slot in the high 32 bits.
+// A handle whose generation no longer matches its slot refers to a task that
+// has already completed and been recycled.
+typedef uint64_t TaskHandle_t;
+#define INVALID_TASK_HANDLE TaskHandle_t(-1)
+
+
+// One live task. The enums are packed into a byte each so that a record fits
+// in 32 bytes, two to a cache line.
+struct TaskRecord {
+   Time_t arrival;
+   Time_t target_completion;
+   VMId_t vm_id;
+   TaskId_t task_id;
+   unsigned memory;
+   uint8_t sla;                // SLAType_t
+   uint8_t vm_type;            // VMType_t
+   uint8_t cpu;                // CPUType_t
+   uint8_t priority;           // Priority_t
+};
+
+
+// What is left of a task once it has completed.
+struct TaskSummary {
+   uint64_t completed;
+   uint64_t violations;
+   Time_t total_turnaround;
+};
+
+
+class TaskTable {
+public:
+   TaskTable()                 {}
+
+   TaskHandle_t Insert(const TaskInfo_t & task_info, VMId_t vm_id);
+   void Release(TaskId_t task_id, Time_t now);
+
+   TaskHandle_t Find(TaskId_t task_id) const;
+   bool IsValid(TaskHandle_t handle) const;
+   TaskRecord & Get(TaskHandle_t handle);
+   const TaskRecord & Get(TaskHandle_t handle) const;
+
+   unsigned Live() const       { return unsigned(index.size()); }
+   unsigned Capacity() const   { return unsigned(slabs.size() * SLAB_SIZE); }
+   const TaskSummary & Summary(SLAType_t sla) const { return summary[sla]; }
+private:
+   static const unsigned SLAB_SIZE = 4096;
+
+   // Slabs are never moved once allocated, so references into them stay
+   // valid while the table grows.
+   vector<unique_ptr<TaskRecord[]>> slabs;
+   vector<uint32_t> generations;
+   vector<uint32_t> free_slots;
+   // Live tasks only. Task ids keep growing over a trace, so an array indexed
+   // by id would grow with the whole trace rather than with the live set.
+   std::unordered_map<TaskId_t, TaskHandle_t> index;
+
+   TaskSummary summary[NUM_SLAS] = {};
+
+   TaskRecord & Slot(uint32_t slot)   { return slabs[slot / SLAB_SIZE][slot % SLAB_SIZE]; }
+   const TaskRecord & Slot(uint32_t slot) const { return slabs[slot / SLAB_SIZE][slot % SLAB_SIZE]; }
+};
+
+
+#endif /* TaskTable_hpp */
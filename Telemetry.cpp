@@ -0,0 +1,215 @@
+//
+//  Telemetry.cpp
+//  CloudSim
+//
+
+
+#include "Telemetry.hpp"
+
+#include <cstring>
+
+
+// Blocks of about a megabyte keep the writes large without holding much memory
+static const size_t BLOCK_BYTES = 1 << 20;
+
+
+void Telemetry::Open(const string & filename, Time_t period, const ChangeFeed & feed, const MachineClasses & machine_classes) {
+   Close();
+   file = fopen(filename.c_str(), "wb");
+   if (file == nullptr) {
+      ThrowException("Telemetry::Open(): Could not create ", filename);
+   }
+   this->feed = &feed;
+   this->machine_classes = &machine_classes;
+   this->period = max(period, Time_t(1));
+   machines = Machine_GetTotal();
+   next_sample = 0;
+   samples = 0;
+   stalls = 0;
+   sampled_energy = 0;
+   write_failed = false;
+
+   TelemetryHeader header = {};
+   memcpy(header.magic, TELEMETRY_MAGIC, sizeof(TELEMETRY_MAGIC));
+   header.machines = machines;
+   header.period = this->period;
+   fwrite(&header, sizeof(header), 1, file);
+
+   size_t frame_bytes = 16 + size_t(machines) * 14;
+   frames_per_block = unsigned(max(BLOCK_BYTES / frame_bytes, size_t(1)));
+   size_t cells = size_t(frames_per_block) * machines;
+   for (Block & block : ring) {
+      block.frames = 0;
+      block.time.resize(frames_per_block);
+      block.active_machines.resize(frames_per_block);
+      block.cluster_power.resize(frames_per_block);
+      block.s_state.resize(cells);
+      block.p_state.resize(cells);
+      block.utilisation.resize(cells);
+      block.memory_used.resize(cells);
+      block.power.resize(cells);
+   }
+   head = tail = full = 0;
+   stopping = false;
+
+   state_power.assign(machine_classes.NumClasses() * S_STATES, 0.0f);
+   calibrated.assign(machine_classes.NumClasses() * S_STATES, false);
+   probes.assign(machine_classes.NumClasses() * S_STATES, Probe());
+
+   writer = std::thread(&Telemetry::Write, this);
+}
+
+
+// The scheduler may be torn down without Shutdown(), and a destructor must not throw
+Telemetry::~Telemetry() {
+   if (!Finish()) {
+      SimOutput("Telemetry::~Telemetry(): Writing the telemetry file failed", 0);
+   }
+}
+
+
+void Telemetry::Close() {
+   if (!Finish()) {
+      ThrowException("Telemetry::Close(): Writing the telemetry file failed");
+   }
+}
+
+
+// Stops the writer and closes the file. False if any write failed.
+bool Telemetry::Finish() {
+   if (file == nullptr) return true;
+   if (ring[head].frames > 0) Submit();
+   {
+      std::lock_guard<std::mutex> guard(lock);
+      stopping = true;
+   }
+   block_ready.notify_one();
+   writer.join();
+   bool closed = fclose(file) == 0;
+   file = nullptr;
+   return closed && !write_failed;
+}
+
+
+void Telemetry::Record(Time_t now) {
+   Block & block = ring[head];
+   unsigned frame = block.frames;
+   size_t base = size_t(frame) * machines;
+   unsigned active = 0;
+   double cluster_power = 0;
+
+   for (unsigned i = 0; i < machines; i++) {
+      const ChangeFeed::MachineSnapshot & snapshot = feed->Snapshot(MachineId_t(i));
+      unsigned class_id = machine_classes->ClassOf(MachineId_t(i));
+      if (!calibrated[class_id * S_STATES + snapshot.s_state]) {
+         Calibrate(now, MachineId_t(i), class_id, snapshot);
+      }
+      float power = Power(class_id, snapshot);
+
+      block.s_state[base + i] = uint8_t(snapshot.s_state);
+      block.p_state[base + i] = uint8_t(snapshot.p_state);
+      block.utilisation[base + i] = snapshot.num_cpus ? float(snapshot.active_tasks) / snapshot.num_cpus : 0.0f;
+      block.memory_used[base + i] = snapshot.memory_used;
+      block.power[base + i] = power;
+      active += snapshot.s_state == S0;
+      cluster_power += power;
+   }
+   block.time[frame] = now;
+   block.active_machines[frame] = active;
+   block.cluster_power[frame] = float(cluster_power);
+
+   if (samples > 0) sampled_energy += double(last_cluster_power) * double(now - last_sample);
+   last_sample = now;
+   last_cluster_power = float(cluster_power);
+   samples++;
+   // Stay on the period's grid even when the timer ticks do not line up with it
+   next_sample += ((now - next_sample) / period + 1) * period;
+
+   if (++block.frames == frames_per_block) Submit();
+}
+
+
+float Telemetry::Power(unsigned class_id, const ChangeFeed::MachineSnapshot & snapshot) const {
+   float power = state_power[class_id * S_STATES + snapshot.s_state];
+   if (snapshot.s_state == S0) {
+      const MachineClass & machine_class = machine_classes->Class(class_id);
+      unsigned busy = min(snapshot.active_tasks, machine_class.num_cpus);
+      power += busy * machine_class.core_power[snapshot.p_state] + (machine_class.num_cpus - busy) * machine_class.c_states[C1];
+   }
+   return power;
+}
+
+
+void Telemetry::Calibrate(Time_t now, MachineId_t machine_id, unsigned class_id, const ChangeFeed::MachineSnapshot & snapshot) {
+   unsigned index = class_id * S_STATES + snapshot.s_state;
+   Probe & probe = probes[index];
+
+   if (probe.machine_id == machine_id) {
+      if (snapshot.active_tasks == probe.active_tasks && snapshot.p_state == probe.p_state && now > probe.time) {
+         // Unchanged for a whole period, so the measured draw is the state's
+         double measured = double(Machine_GetEnergy(machine_id) - probe.energy) / double(now - probe.time);
+         float cores = Power(class_id, snapshot) - state_power[index];
+         state_power[index] = float(measured) - cores;
+         calibrated[index] = true;
+         SimOutput("Telemetry::Calibrate(): Class " + to_string(class_id) + " draws " + to_string(state_power[index]) +
+                   " W in S-state " + to_string(snapshot.s_state), 3);
+         return;
+      }
+   } else if (probe.machine_id != MachineId_t(-1)) {
+      // Keep the running probe unless its machine has moved on
+      const ChangeFeed::MachineSnapshot & current = feed->Snapshot(probe.machine_id);
+      if (current.s_state == snapshot.s_state && current.active_tasks == probe.active_tasks && current.p_state == probe.p_state) return;
+   }
+   probe.machine_id = machine_id;
+   probe.energy = Machine_GetEnergy(machine_id);
+   probe.time = now;
+   probe.active_tasks = snapshot.active_tasks;
+   probe.p_state = snapshot.p_state;
+}
+
+
+void Telemetry::Submit() {
+   std::unique_lock<std::mutex> guard(lock);
+   full++;
+   head = (head + 1) % RING_BLOCKS;
+   block_ready.notify_one();
+   // The next block is still queued for the writer
+   while (full == RING_BLOCKS) {
+      stalls++;
+      block_free.wait(guard);
+   }
+   ring[head].frames = 0;
+}
+
+
+void Telemetry::Write() {
+   std::unique_lock<std::mutex> guard(lock);
+   for (;;) {
+      block_ready.wait(guard, [this] { return full > 0 || stopping; });
+      if (full == 0) break;
+      const Block & block = ring[tail];
+      guard.unlock();
+      WriteBlock(block);
+      guard.lock();
+      tail = (tail + 1) % RING_BLOCKS;
+      full--;
+      block_free.notify_one();
+   }
+}
+
+
+void Telemetry::WriteBlock(const Block & block) {
+   size_t frames = block.frames;
+   size_t cells = frames * machines;
+   uint32_t counts[2] = {uint32_t(frames), machines};
+   bool ok = fwrite(counts, sizeof(counts), 1, file) == 1;
+   ok = ok && fwrite(block.time.data(), sizeof(uint64_t), frames, file) == frames;
+   ok = ok && fwrite(block.active_machines.data(), sizeof(uint32_t), frames, file) == frames;
+   ok = ok && fwrite(block.cluster_power.data(), sizeof(float), frames, file) == frames;
+   ok = ok && fwrite(block.s_state.data(), sizeof(uint8_t), cells, file) == cells;
+   ok = ok && fwrite(block.p_state.data(), sizeof(uint8_t), cells, file) == cells;
+   ok = ok && fwrite(block.utilisation.data(), sizeof(float), cells, file) == cells;
+   ok = ok && fwrite(block.memory_used.data(), sizeof(uint32_t), cells, file) == cells;
+   ok = ok && fwrite(block.power.data(), sizeof(float), cells, file) == cells;
+   if (!ok) write_failed = true;
+}
@@ -0,0 +1,135 @@
+//
+//  Telemetry.hpp
+//  CloudSim
+//
+//  Time series of the cluster. Every sampling period the scheduler's timer
+//  callback records, for every machine, its S-state, P-state, core
+//  utilisation, memory in use and power draw, plus the number of machines in
+//  S0 and the cluster's power. The readings come from the change feed's
+//  snapshots, not from the simulator, and power is computed from the
+//  machine's class tables; the S-state power that the simulator does not
+//  report is calibrated once per class and state from the measured energy of
+//  one machine. Samples go into preallocated blocks in a small ring, and a
+//  writer thread flushes full blocks to a columnar file while the simulation
+//  keeps running.
+//
+//  File layout: a TelemetryHeader, then blocks of up to `frames` samples. A
+//  block starts with two uint32 (frames, machines) and holds one column after
+//  the other:
+//     time               uint64[frames]      simulated us
+//     active_machines    uint32[frames]      machines in S0
+//     cluster_power      float[frames]       W
+//     s_state            uint8[frames][machines]
+//     p_state            uint8[frames][machines]
+//     utilisation        float[frames][machines]   active tasks per core
+//     memory_used        uint32[frames][machines]  MB
+//     power              float[frames][machines]   W
+//
+
+
+#ifndef Telemetry_hpp
+#define Telemetry_hpp
+
+
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ChangeFeed.hpp"
+#include "MachineClasses.hpp"
+
+
+struct TelemetryHeader {
+   char magic[8];                      // "CSTEL1\0\0"
+   uint32_t machines;
+   uint32_t reserved;
+   uint64_t period;                    // sampling period in us
+};
+
+#define TELEMETRY_MAGIC "CSTEL1"
+
+
+class Telemetry {
+public:
+   Telemetry()                 {}
+   ~Telemetry();
+   // Throws if the file cannot be created. `feed` and `machine_classes` must be initialised.
+   void Open(const string & filename, Time_t period, const ChangeFeed & feed, const MachineClasses & machine_classes);
+   // Writes what is left and closes the file; throws if any write failed
+   void Close();
+   bool Enabled() const        { return file != nullptr; }
+
+   // Call on every timer tick; takes a sample once a period has passed
+   void Sample(Time_t now) {
+      if (file != nullptr && now >= next_sample) Record(now);
+   }
+
+   uint64_t Samples() const    { return samples; }
+   // Times the simulation had to wait for the writer
+   uint64_t Stalls() const     { return stalls; }
+   // Integral of the sampled cluster power, in KW-Hour, to compare with the measured energy
+   double SampledEnergy() const  { return sampled_energy / 3.6e12; }
+private:
+   struct Block {
+      unsigned frames = 0;
+      vector<uint64_t> time;
+      vector<uint32_t> active_machines;
+      vector<float> cluster_power;
+      vector<uint8_t> s_state;
+      vector<uint8_t> p_state;
+      vector<float> utilisation;
+      vector<uint32_t> memory_used;
+      vector<float> power;
+   };
+   // Measures one machine across a sampling period to learn a class's power in an S-state
+   struct Probe {
+      MachineId_t machine_id = MachineId_t(-1);
+      uint64_t energy = 0;
+      Time_t time = 0;
+      unsigned active_tasks = 0;
+      CPUPerformance_t p_state = P0;
+   };
+
+   FILE * file = nullptr;
+   const ChangeFeed * feed = nullptr;
+   const MachineClasses * machine_classes = nullptr;
+   unsigned machines = 0;
+   unsigned frames_per_block = 0;
+   Time_t period = 0;
+   Time_t next_sample = 0;
+   Time_t last_sample = 0;
+   float last_cluster_power = 0;
+   uint64_t samples = 0;
+   uint64_t stalls = 0;
+   double sampled_energy = 0;          // W x us
+
+   // Static power of each class in each S-state; cores are added on top in S0
+   vector<float> state_power;          // [class * S_STATES + state]
+   vector<bool> calibrated;
+   vector<Probe> probes;
+
+   static const unsigned RING_BLOCKS = 4;
+   Block ring[RING_BLOCKS];
+   unsigned head = 0;                  // block being filled
+   unsigned tail = 0;                  // next block to write
+   unsigned full = 0;                  // blocks waiting for the writer
+   bool stopping = false;
+   bool write_failed = false;          // set by the writer, read after it has stopped
+   std::mutex lock;
+   std::condition_variable block_ready;
+   std::condition_variable block_free;
+   std::thread writer;
+
+   bool Finish();
+   void Record(Time_t now);
+   float Power(unsigned class_id, const ChangeFeed::MachineSnapshot & snapshot) const;
+   void Calibrate(Time_t now, MachineId_t machine_id, unsigned class_id, const ChangeFeed::MachineSnapshot & snapshot);
+   void Submit();
+   void Write();
+   void WriteBlock(const Block & block);
+};
+
+
+#endif /* Telemetry_hpp */
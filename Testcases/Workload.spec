@@ -0,0 +1,83 @@
+# Workload spec for ./workloadgen: machine classes are copied as is,
+# workload classes become task classes of constant rate.
+machine class:
+{
+        Number of machines: 16
+        CPU type: X86
+        Number of cores: 8
+        Memory: 16384
+        S-States: [120, 100, 100, 80, 40, 10, 0]
+        P-States: [12, 8, 6, 4]
+        C-States: [12, 3, 1, 0]
+        MIPS: [3000, 2400, 2000, 1500]
+        GPUs: no
+}
+
+# Web traffic that follows the day, peaking in the afternoon
+workload class:
+{
+        Start time: 60000
+        End time: 86400000000
+        Arrival model: DIURNAL
+        Rate: 4
+        Amplitude: 0.8
+        Period: 86400000000
+        Phase: 21600000000
+        Segment length: 900000000
+        Runtime distribution: LOGNORMAL
+        Runtime: 1000000
+        Runtime shape: 0.8
+        Memory distribution: FIXED
+        Memory: 8
+        Mixture: 4
+        VM type: LINUX
+        GPU enabled: no
+        SLA type: SLA2
+        CPU type: X86
+        Task type: WEB
+        Seed: 520230
+}
+
+# Bursty batch jobs with heavy-tailed runtimes and memory
+workload class:
+{
+        Start time: 60000
+        End time: 86400000000
+        Arrival model: MMPP
+        Rate: 0.05
+        Burst rate: 2
+        Calm length: 3600000000
+        Burst length: 300000000
+        Runtime distribution: PARETO
+        Runtime: 5000000
+        Runtime shape: 1.5
+        Memory distribution: PARETO
+        Memory: 64
+        Memory shape: 2
+        Mixture: 2
+        VM type: LINUX
+        GPU enabled: no
+        SLA type: SLA3
+        CPU type: X86
+        Task type: HPC
+        Seed: 77
+}
+
+# Replayed arrival rate curve
+workload class:
+{
+        Start time: 0
+        End time: 86400000000
+        Arrival model: TRACE
+        Trace: [0:0.5, 28800000000:3, 43200000000:1, 64800000000:2.5, 79200000000:0.5]
+        Runtime distribution: EXPONENTIAL
+        Runtime: 500000
+        Memory distribution: FIXED
+        Memory: 16
+        VM type: LINUX
+        GPU enabled: no
+        SLA type: SLA1
+        CPU type: X86
+        Task type: WEB
+        Seed: 9001
+}
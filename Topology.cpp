@@ -0,0 +1,88 @@
+//
+//  Topology.cpp
+//  CloudSim
+//
+
+
+#include "Topology.hpp"
+
+#include "ConfigParser.hpp"
+
+
+// W over a span of microseconds, in KW-Hour
+static double KWHour(double watts, Time_t span) {
+   return watts * double(span) / 1e6 / 3600.0 / 1000.0;
+}
+
+
+void Topology::Load(const string & filename, unsigned total_machines) {
+   SimulatorConfig config;
+   try {
+      ParseConfigFile(filename, config);
+   } catch (const exception & e) {
+      ThrowException("Topology::Load(): ", e.what());
+   }
+
+   rack_of.assign(total_machines, NO_RACK);
+   awake.assign(total_machines, false);
+   MachineId_t next_machine = 0;
+
+   for (const RackClassSpec & rack_class : config.rack_classes) {
+      for (unsigned r = 0; r < rack_class.racks && next_machine < total_machines; r++) {
+         Rack rack;
+         rack.static_power = rack_class.static_power;
+         racks.push_back(rack);
+         for (unsigned m = 0; m < rack_class.machines_per_rack && next_machine < total_machines; m++) {
+            rack_of[next_machine++] = unsigned(racks.size() - 1);
+         }
+      }
+   }
+   SimOutput("Topology::Load(): " + to_string(racks.size()) + " racks over " + to_string(next_machine) + " machines", 1);
+}
+
+
+unsigned Topology::AwakeInRack(MachineId_t machine_id) const {
+   unsigned rack = RackOf(machine_id);
+   return rack == NO_RACK ? 0 : racks[rack].awake;
+}
+
+
+unsigned Topology::WakePower(MachineId_t machine_id) const {
+   unsigned rack = RackOf(machine_id);
+   return rack == NO_RACK || racks[rack].awake > 0 ? 0 : racks[rack].static_power;
+}
+
+
+void Topology::MachineStateChanged(Time_t now, MachineId_t machine_id, MachineState_t state) {
+   unsigned rack_id = RackOf(machine_id);
+   bool is_awake = state != S5;
+   if (rack_id == NO_RACK || awake[machine_id] == is_awake) return;
+   awake[machine_id] = is_awake;
+
+   Rack & rack = racks[rack_id];
+   if (is_awake) {
+      if (rack.awake++ == 0) {
+         rack.powered_since = now;
+         lit_power += rack.static_power;
+         lit_offset += double(rack.static_power) * double(now);
+      }
+   } else if (--rack.awake == 0) {
+      double spent = KWHour(rack.static_power, now - rack.powered_since);
+      rack.energy += spent;
+      closed_energy += spent;
+      lit_power -= rack.static_power;
+      lit_offset -= double(rack.static_power) * double(rack.powered_since);
+   }
+}
+
+
+double Topology::RackEnergy(unsigned rack_id, Time_t now) const {
+   const Rack & rack = racks[rack_id];
+   return rack.energy + (rack.awake > 0 ? KWHour(rack.static_power, now - rack.powered_since) : 0);
+}
+
+
+double Topology::TotalEnergy(Time_t now) const {
+   // Sum over the lit racks of power * (now - powered_since), without visiting them
+   return closed_energy + KWHour(1, 1) * (double(lit_power) * double(now) - lit_offset);
+}
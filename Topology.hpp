@@ -0,0 +1,75 @@
+//
+//  Topology.hpp
+//  CloudSim
+//
+//  Optional rack layout of the cluster. A topology file holds `rack class:`
+//  blocks in the same syntax as the simulator input:
+//
+//     rack class:
+//     {
+//             Number of racks: 4
+//             Machines per rack: 10
+//             Static power: 600
+//     }
+//
+//  Racks are filled with machines in id order. Static power (W) stands for
+//  the PDU, switches and cooling of a rack and is drawn as long as any of its
+//  machines is out of S5. The file is read with ConfigParser, so the
+//  simulator input itself can carry the rack classes (the simulator ignores
+//  them) and its other blocks are validated on the way. The rack energy is
+//  accumulated as machines change state, never recomputed.
+//
+
+
+#ifndef Topology_hpp
+#define Topology_hpp
+
+
+#include <string>
+#include <vector>
+
+#include "ChangeFeed.hpp"
+#include "Interfaces.h"
+
+
+#define NO_RACK unsigned(-1)
+
+
+struct Rack {
+   unsigned static_power = 0;  // W
+   unsigned awake = 0;         // machines not in S5
+   Time_t powered_since = 0;   // valid while awake > 0
+   double energy = 0;          // KW-Hour up to powered_since
+};
+
+
+class Topology : public ChangeListener {
+public:
+   Topology()                  {}
+   // Reads the rack classes from `filename`. Machines beyond the racks stay
+   // outside the topology. Throws on a malformed file.
+   void Load(const string & filename, unsigned total_machines);
+   bool Enabled() const                             { return !racks.empty(); }
+
+   unsigned RackOf(MachineId_t machine_id) const    { return machine_id < rack_of.size() ? rack_of[machine_id] : NO_RACK; }
+   unsigned NumRacks() const                        { return unsigned(racks.size()); }
+   // Machines of the rack that are awake; 0 for machines outside the topology
+   unsigned AwakeInRack(MachineId_t machine_id) const;
+   // Extra power switched on by waking the machine: its rack's static power if the rack is dark
+   unsigned WakePower(MachineId_t machine_id) const;
+
+   void MachineStateChanged(Time_t now, MachineId_t machine_id, MachineState_t state) override;
+
+   double RackEnergy(unsigned rack, Time_t now) const;
+   double TotalEnergy(Time_t now) const;
+private:
+   vector<Rack> racks;
+   vector<unsigned> rack_of;
+   vector<bool> awake;
+   double closed_energy = 0;   // KW-Hour of every finished powered span
+   unsigned lit_power = 0;     // static power of the racks that are on
+   double lit_offset = 0;      // sum of static_power * powered_since over those racks
+};
+
+
+#endif /* Topology_hpp */
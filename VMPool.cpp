@@ -0,0 +1,124 @@
+//
+//  VMPool.cpp
+//  CloudSim
+//
+
+
+#include "VMPool.hpp"
+
+
+void VMPool::Init(unsigned total_machines) {
+   free_lists.assign(total_machines * NUM_VM_TYPES, vector<VMId_t>());
+}
+
+
+void VMPool::Track(Time_t now, VMId_t vm_id, MachineId_t machine_id, VMType_t vm_type) {
+   Register(vm_id, machine_id, vm_type);
+   MarkIdle(now, vm_id);
+}
+
+
+void VMPool::Register(VMId_t vm_id, MachineId_t machine_id, VMType_t vm_type) {
+   if (vm_id >= pooled.size()) {
+      pooled.resize(vm_id + 1, PooledVM());
+   }
+   pooled[vm_id] = {machine_id, vm_type, 0, 0, false, true};
+   live++;
+   peak = max(peak, live);
+}
+
+
+VMId_t VMPool::Acquire(MachineId_t machine_id, VMType_t vm_type, CPUType_t cpu, bool & created) {
+   vector<VMId_t> & free_list = free_lists[machine_id * NUM_VM_TYPES + vm_type];
+   if (!free_list.empty()) {
+      // The most recently idled VM, so the older ones can still time out
+      VMId_t vm_id = free_list.back();
+      MarkBusy(vm_id);
+      reused++;
+      created = false;
+      return vm_id;
+   }
+
+   VMId_t vm_id = VM_Create(vm_type, cpu);
+   VM_Attach(vm_id, machine_id);
+   Register(vm_id, machine_id, vm_type);
+   created = true;
+   return vm_id;
+}
+
+
+void VMPool::MarkIdle(Time_t now, VMId_t vm_id) {
+   if (vm_id >= pooled.size() || !pooled[vm_id].live || pooled[vm_id].idle) return;
+
+   PooledVM & vm = pooled[vm_id];
+   vector<VMId_t> & free_list = FreeList(vm);
+   vm.idle = true;
+   vm.idle_since = now;
+   vm.slot = unsigned(free_list.size());
+   free_list.push_back(vm_id);
+   idle_order.push_back({now, vm_id});
+}
+
+
+void VMPool::MarkBusy(VMId_t vm_id) {
+   if (vm_id >= pooled.size() || !pooled[vm_id].idle) return;
+   Unlist(vm_id);
+}
+
+
+void VMPool::Moved(VMId_t vm_id, MachineId_t machine_id) {
+   if (vm_id >= pooled.size() || !pooled[vm_id].live) return;
+
+   PooledVM & vm = pooled[vm_id];
+   if (!vm.idle) {
+      vm.machine_id = machine_id;
+      return;
+   }
+
+   // Move it to the new machine's free list only; its idle_order entry keeps
+   // its place, since idle_since does not change
+   Unlist(vm_id);
+   vm.machine_id = machine_id;
+   vector<VMId_t> & free_list = FreeList(vm);
+   vm.idle = true;
+   vm.slot = unsigned(free_list.size());
+   free_list.push_back(vm_id);
+}
+
+
+void VMPool::Unlist(VMId_t vm_id) {
+   PooledVM & vm = pooled[vm_id];
+   vector<VMId_t> & free_list = FreeList(vm);
+   VMId_t last = free_list.back();
+   free_list[vm.slot] = last;
+   pooled[last].slot = vm.slot;
+   free_list.pop_back();
+   vm.idle = false;
+}
+
+
+void VMPool::Retire(Time_t now, Time_t timeout, vector<VMId_t> & retired) {
+   vector<pair<Time_t, VMId_t>> asleep;
+   while (!idle_order.empty() && idle_order.front().first + timeout <= now) {
+      Time_t since = idle_order.front().first;
+      VMId_t vm_id = idle_order.front().second;
+      idle_order.pop_front();
+
+      // The VM may have been reused (and maybe idled again) since this entry was queued
+      PooledVM & vm = pooled[vm_id];
+      if (!vm.live || !vm.idle || vm.idle_since != since) continue;
+
+      // The simulator cannot detach a VM from a sleeping machine; try again once it is up
+      if (Machine_GetInfo(vm.machine_id).s_state != S0) {
+         asleep.push_back({since, vm_id});
+         continue;
+      }
+
+      Unlist(vm_id);
+      VM_Shutdown(vm_id);
+      vm.live = false;
+      live--;
+      retired.push_back(vm_id);
+   }
+   idle_order.insert(idle_order.begin(), asleep.begin(), asleep.end());
+}
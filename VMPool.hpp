@@ -0,0 +1,69 @@
+//
+//  VMPool.hpp
+//  CloudSim
+//
+//  Recycles empty VMs. Every VM the scheduler owns is registered here; once
+//  it runs out of tasks it goes on the free list of its (machine, VM type)
+//  pair, where the next placement of that type on that machine picks it up
+//  instead of creating a new one. VMs left on a free list for longer than the
+//  idle timeout are shut down, so the number of VMs follows the live load.
+//
+
+
+#ifndef VMPool_hpp
+#define VMPool_hpp
+
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "AdmissionQueue.hpp"
+#include "Interfaces.h"
+
+
+class VMPool {
+public:
+   VMPool()                    {}
+   void Init(unsigned total_machines);
+
+   // Registers a VM created outside the pool. It starts out idle.
+   void Track(Time_t now, VMId_t vm_id, MachineId_t machine_id, VMType_t vm_type);
+   // An idle VM of the type on the machine, or a freshly created and attached
+   // one, in which case `created` is set. The VM is marked busy.
+   VMId_t Acquire(MachineId_t machine_id, VMType_t vm_type, CPUType_t cpu, bool & created);
+
+   void MarkIdle(Time_t now, VMId_t vm_id);
+   void MarkBusy(VMId_t vm_id);
+   void Moved(VMId_t vm_id, MachineId_t machine_id);
+
+   // Shuts down the VMs that have been idle for at least `timeout` and
+   // appends them to `retired` so the caller can drop its own references
+   void Retire(Time_t now, Time_t timeout, vector<VMId_t> & retired);
+
+   unsigned Live() const       { return live; }
+   unsigned Peak() const       { return peak; }
+   unsigned Reused() const     { return reused; }
+private:
+   struct PooledVM {
+      MachineId_t machine_id;
+      VMType_t vm_type;
+      Time_t idle_since;
+      unsigned slot;           // position in its free list while idle
+      bool idle;
+      bool live;
+   };
+   vector<PooledVM> pooled;                    // indexed by VMId_t
+   vector<vector<VMId_t>> free_lists;          // indexed by machine * NUM_VM_TYPES + VM type
+   deque<pair<Time_t, VMId_t>> idle_order;     // oldest first; stale entries are skipped
+   unsigned live = 0;
+   unsigned peak = 0;
+   unsigned reused = 0;
+
+   vector<VMId_t> & FreeList(const PooledVM & vm) { return free_lists[vm.machine_id * NUM_VM_TYPES + vm.vm_type]; }
+   void Register(VMId_t vm_id, MachineId_t machine_id, VMType_t vm_type);
+   void Unlist(VMId_t vm_id);
+};
+
+
+#endif /* VMPool_hpp */
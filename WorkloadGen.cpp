@@ -0,0 +1,326 @@
+//
+//  WorkloadGen.cpp
+//  CloudSim
+//
+
+
+#include "WorkloadGen.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+
+static uint64_t SplitMix64(uint64_t & state) {
+   uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+   z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+   z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+   return z ^ (z >> 31);
+}
+
+
+static inline uint64_t Rotl(uint64_t x, int k) {
+   return (x << k) | (x >> (64 - k));
+}
+
+
+Xoshiro256::Xoshiro256(uint64_t seed) {
+   for (unsigned i = 0; i < 4; i++) {
+      s[i] = SplitMix64(seed);
+   }
+}
+
+
+uint64_t Xoshiro256::Next() {
+   uint64_t result = Rotl(s[1] * 5, 7) * 9;
+   uint64_t t = s[1] << 17;
+   s[2] ^= s[0];
+   s[3] ^= s[1];
+   s[1] ^= s[2];
+   s[0] ^= s[3];
+   s[2] ^= t;
+   s[3] = Rotl(s[3], 45);
+   return result;
+}
+
+
+void Xoshiro256::FillDouble(double * out, size_t n) {
+   for (size_t i = 0; i < n; i++) {
+      out[i] = NextDouble();
+   }
+}
+
+
+double Distribution::Sample(Xoshiro256 & rng) const {
+   double value;
+   SampleBlock(rng, &value, 1);
+   return value;
+}
+
+
+void Distribution::SampleBlock(Xoshiro256 & rng, double * out, size_t n) const {
+   if (kind == FIXED) {
+      std::fill(out, out + n, mean);
+      return;
+   }
+
+   if (kind == LOGNORMAL) {
+      // Box-Muller turns every pair of uniforms into a pair of normals
+      vector<double> uniforms((n + 1) & ~size_t(1));
+      rng.FillDouble(uniforms.data(), uniforms.size());
+      for (size_t i = 0; i < n; i += 2) {
+         double radius = sqrt(-2.0 * log(1.0 - uniforms[i]));
+         double angle = 2.0 * M_PI * uniforms[i + 1];
+         out[i] = mean * exp(shape * radius * cos(angle));
+         if (i + 1 < n) {
+            out[i + 1] = mean * exp(shape * radius * sin(angle));
+         }
+      }
+      return;
+   }
+
+   rng.FillDouble(out, n);
+   if (kind == EXPONENTIAL) {
+      for (size_t i = 0; i < n; i++) {
+         out[i] = -mean * log(1.0 - out[i]);
+      }
+   } else {
+      double inverse_alpha = 1.0 / shape;
+      for (size_t i = 0; i < n; i++) {
+         out[i] = mean / pow(1.0 - out[i], inverse_alpha);
+      }
+   }
+}
+
+
+SegmentGenerator::SegmentGenerator(const WorkloadClass & workload) : workload(workload), rng(workload.seed), now(workload.start) {
+   if (workload.model == MMPP) {
+      state_end = workload.start + Time_t(-workload.calm_length * log(1.0 - rng.NextDouble()));
+   }
+}
+
+
+Time_t SegmentGenerator::Boundary(Time_t time) {
+   switch (workload.model) {
+      case MMPP:
+         while (state_end <= time) {
+            bursty = !bursty;
+            double length = bursty ? workload.burst_length : workload.calm_length;
+            state_end += max(Time_t(-length * log(1.0 - rng.NextDouble())), Time_t(1));
+         }
+         return state_end;
+      case TRACE:
+         while (trace_index < workload.trace.size() && workload.trace[trace_index].first <= time) {
+            trace_index++;
+         }
+         return trace_index < workload.trace.size() ? workload.trace[trace_index].first : workload.end;
+      default:
+         return workload.end;
+   }
+}
+
+
+double SegmentGenerator::RateAt(Time_t time) {
+   switch (workload.model) {
+      case MMPP:
+         return bursty ? workload.burst_rate : workload.rate;
+      case DIURNAL:
+         return max(0.0, workload.rate * (1.0 + workload.amplitude * sin(2.0 * M_PI * (double(time) - workload.phase) / workload.period)));
+      case TRACE:
+         // trace_index already points past the last point at or before `time`
+         return trace_index == 0 ? 0.0 : workload.trace[trace_index - 1].second;
+      default:
+         return workload.rate;
+   }
+}
+
+
+bool SegmentGenerator::Next(RateSegment & segment) {
+   if (now >= workload.end) return false;
+
+   Time_t boundary = min(min(workload.end, now + workload.segment_length), Boundary(now));
+   segment.start = now;
+   segment.end = boundary;
+   segment.rate = RateAt(workload.model == DIURNAL ? now + (boundary - now) / 2 : now);
+   now = boundary;
+   return true;
+}
+
+
+// ---------------------------------------------------------------------------
+// Spec reader
+
+
+static string Trim(const string & s) {
+   size_t first = s.find_first_not_of(" \t\r");
+   if (first == string::npos) return "";
+   size_t last = s.find_last_not_of(" \t\r");
+   return s.substr(first, last - first + 1);
+}
+
+
+static DistributionKind_t DistributionFromName(const string & name) {
+   if (name == "FIXED") return FIXED;
+   if (name == "EXPONENTIAL") return EXPONENTIAL;
+   if (name == "LOGNORMAL") return LOGNORMAL;
+   if (name == "PARETO") return PARETO;
+   throw runtime_error("ReadWorkloadSpec(): Unknown distribution " + name);
+}
+
+
+static ArrivalModel_t ModelFromName(const string & name) {
+   if (name == "POISSON") return POISSON;
+   if (name == "MMPP") return MMPP;
+   if (name == "DIURNAL") return DIURNAL;
+   if (name == "TRACE") return TRACE;
+   throw runtime_error("ReadWorkloadSpec(): Unknown arrival model " + name);
+}
+
+
+// "[time:rate, time:rate, ...]"
+static vector<pair<Time_t, double>> ReadTrace(const string & value) {
+   if (value.size() < 2 || value.front() != '[' || value.back() != ']') {
+      throw runtime_error("ReadWorkloadSpec(): Expected [time:rate, ...] but found " + value);
+   }
+   vector<pair<Time_t, double>> trace;
+   size_t pos = 1;
+   while (pos < value.size() - 1) {
+      size_t comma = value.find(',', pos);
+      if (comma == string::npos) comma = value.size() - 1;
+      string point = Trim(value.substr(pos, comma - pos));
+      size_t colon = point.find(':');
+      if (colon == string::npos) {
+         throw runtime_error("ReadWorkloadSpec(): Expected time:rate but found " + point);
+      }
+      trace.push_back({Time_t(stoull(point.substr(0, colon))), stod(point.substr(colon + 1))});
+      pos = comma + 1;
+   }
+   std::sort(trace.begin(), trace.end());
+   return trace;
+}
+
+
+static void SetField(WorkloadClass & workload, const string & key, const string & value) {
+   if (key == "Start time") workload.start = stoull(value);
+   else if (key == "End time") workload.end = stoull(value);
+   else if (key == "Arrival model") workload.model = ModelFromName(value);
+   else if (key == "Rate") workload.rate = stod(value);
+   else if (key == "Burst rate") workload.burst_rate = stod(value);
+   else if (key == "Calm length") workload.calm_length = stod(value);
+   else if (key == "Burst length") workload.burst_length = stod(value);
+   else if (key == "Amplitude") workload.amplitude = stod(value);
+   else if (key == "Period") workload.period = stod(value);
+   else if (key == "Phase") workload.phase = stod(value);
+   else if (key == "Trace") workload.trace = ReadTrace(value);
+   else if (key == "Runtime distribution") workload.runtime.kind = DistributionFromName(value);
+   else if (key == "Runtime") workload.runtime.mean = stod(value);
+   else if (key == "Runtime shape") workload.runtime.shape = stod(value);
+   else if (key == "Memory distribution") workload.memory.kind = DistributionFromName(value);
+   else if (key == "Memory") workload.memory.mean = stod(value);
+   else if (key == "Memory shape") workload.memory.shape = stod(value);
+   else if (key == "Segment length") workload.segment_length = max(stoull(value), 1ull);
+   else if (key == "Mixture") workload.mixture = max(unsigned(stoul(value)), 1u);
+   else if (key == "VM type") workload.vm_type = value;
+   else if (key == "GPU enabled") workload.gpu = value;
+   else if (key == "SLA type") workload.sla = value;
+   else if (key == "CPU type") workload.cpu = value;
+   else if (key == "Task type") workload.task_type = value;
+   else if (key == "Seed") workload.seed = stoull(value);
+   else throw runtime_error("ReadWorkloadSpec(): Unknown workload key " + key);
+}
+
+
+void ReadWorkloadSpec(const string & filename, vector<WorkloadClass> & workloads, string & machine_classes) {
+   ifstream in(filename);
+   if (!in) {
+      throw runtime_error("ReadWorkloadSpec(): Could not open " + filename);
+   }
+
+   string raw;
+   while (getline(in, raw)) {
+      string line = Trim(raw.substr(0, raw.find('#')));
+      if (line.empty()) continue;
+
+      if (line == "machine class:") {
+         // Passed through untouched, the simulator parses these
+         machine_classes += line + "\n";
+         while (getline(in, raw)) {
+            machine_classes += raw + "\n";
+            if (Trim(raw) == "}") break;
+         }
+         machine_classes += "\n";
+         continue;
+      }
+      if (line != "workload class:") {
+         throw runtime_error("ReadWorkloadSpec(): Expected 'machine class:' or 'workload class:' but found " + line);
+      }
+
+      if (!getline(in, raw) || Trim(raw) != "{") {
+         throw runtime_error("ReadWorkloadSpec(): Expected { after workload class:");
+      }
+      WorkloadClass workload;
+      bool closed = false;
+      while (getline(in, raw)) {
+         line = Trim(raw.substr(0, raw.find('#')));
+         if (line.empty()) continue;
+         if (line == "}") {
+            closed = true;
+            break;
+         }
+         size_t colon = line.find(':');
+         if (colon == string::npos) {
+            throw runtime_error("ReadWorkloadSpec(): Expected 'keyword: value' but found " + line);
+         }
+         SetField(workload, Trim(line.substr(0, colon)), Trim(line.substr(colon + 1)));
+      }
+      if (!closed) {
+         throw runtime_error("ReadWorkloadSpec(): Missing } at the end of a workload class");
+      }
+      if (workload.end <= workload.start) {
+         throw runtime_error("ReadWorkloadSpec(): End time must come after start time");
+      }
+      workloads.push_back(workload);
+   }
+}
+
+
+double WriteWorkload(ostream & out, const vector<WorkloadClass> & workloads, const string & machine_classes) {
+   out << machine_classes;
+
+   double expected_tasks = 0;
+   for (const WorkloadClass & workload : workloads) {
+      Xoshiro256 rng(workload.seed ^ 0x5DEECE66Dull);
+      SegmentGenerator segments(workload);
+      vector<double> runtimes(workload.mixture), memories(workload.mixture);
+
+      RateSegment segment;
+      while (segments.Next(segment)) {
+         if (segment.rate <= 0) continue;
+         expected_tasks += segment.rate * double(segment.end - segment.start) / 1e6;
+
+         // The segment's arrivals are split over `mixture` independent streams,
+         // each with its own runtime and memory draw
+         workload.runtime.SampleBlock(rng, runtimes.data(), workload.mixture);
+         workload.memory.SampleBlock(rng, memories.data(), workload.mixture);
+         Time_t inter_arrival = max(Time_t(1e6 * workload.mixture / segment.rate), Time_t(1));
+
+         for (unsigned k = 0; k < workload.mixture; k++) {
+            out << "task class:\n{\n"
+                << "        Start time: " << segment.start << "\n"
+                << "        End time : " << segment.end << "\n"
+                << "        Inter arrival: " << inter_arrival << "\n"
+                << "        Expected runtime: " << max(Time_t(runtimes[k]), Time_t(1)) << "\n"
+                << "        Memory: " << max(unsigned(memories[k]), 1u) << "\n"
+                << "        VM type: " << workload.vm_type << "\n"
+                << "        GPU enabled: " << workload.gpu << "\n"
+                << "        SLA type: " << workload.sla << "\n"
+                << "        CPU type: " << workload.cpu << "\n"
+                << "        Task type: " << workload.task_type << "\n"
+                << "        Seed: " << (rng.Next() & 0x7FFFFFFF) << "\n"
+                << "}\n";
+         }
+      }
+   }
+   return expected_tasks;
+}
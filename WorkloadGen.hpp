@@ -0,0 +1,130 @@
+//
+//  WorkloadGen.hpp
+//  CloudSim
+//
+//  Workload generator library. A workload spec uses the same block syntax as
+//  the simulator input, with `workload class:` blocks that describe an arrival
+//  process (Poisson, MMPP, diurnal or trace-driven) and runtime/memory
+//  distributions (fixed, exponential, lognormal, Pareto). The generator cuts
+//  the arrival process into segments of constant rate and emits each segment
+//  as ordinary `task class:` blocks, so the simulator reads the result as is.
+//  Segments are produced one at a time, so the cost is proportional to the
+//  number of segments and not to the number of tasks.
+//
+
+
+#ifndef WorkloadGen_hpp
+#define WorkloadGen_hpp
+
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "SimTypes.h"
+
+
+// xoshiro256** seeded through splitmix64
+class Xoshiro256 {
+public:
+   explicit Xoshiro256(uint64_t seed);
+   uint64_t Next();
+   double NextDouble()         { return (Next() >> 11) * 0x1.0p-53; }   // [0, 1)
+   void FillDouble(double * out, size_t n);
+private:
+   uint64_t s[4];
+};
+
+
+typedef enum {
+   FIXED,
+   EXPONENTIAL,
+   LOGNORMAL,                  // `mean` is the median, `shape` is sigma
+   PARETO                      // `mean` is the scale (minimum), `shape` is alpha
+} DistributionKind_t;
+
+
+struct Distribution {
+   DistributionKind_t kind = FIXED;
+   double mean = 0;
+   double shape = 1;
+
+   double Sample(Xoshiro256 & rng) const;
+   // Fills a whole block at once; the transforms run over plain arrays so the
+   // compiler can vectorise them.
+   void SampleBlock(Xoshiro256 & rng, double * out, size_t n) const;
+};
+
+
+typedef enum {
+   POISSON,                    // constant rate
+   MMPP,                       // two-state Markov modulated Poisson process
+   DIURNAL,                    // rate * (1 + amplitude * sin(2 pi (t - phase) / period))
+   TRACE                       // piecewise constant rate curve
+} ArrivalModel_t;
+
+
+struct WorkloadClass {
+   Time_t start = 0;
+   Time_t end = 0;
+   ArrivalModel_t model = POISSON;
+   double rate = 1;                         // arrivals per second
+   double burst_rate = 0;                   // MMPP: rate in the bursty state
+   double calm_length = 1e6;                // MMPP: mean time in the calm state (us)
+   double burst_length = 1e6;               // MMPP: mean time in the bursty state (us)
+   double amplitude = 0;                    // DIURNAL
+   double period = 86400e6;                 // DIURNAL (us)
+   double phase = 0;                        // DIURNAL (us)
+   vector<pair<Time_t, double>> trace;      // TRACE: (time, arrivals per second)
+
+   Distribution runtime;                    // us
+   Distribution memory;                     // MB
+
+   Time_t segment_length = 600000000;       // longest stretch emitted at one rate
+   unsigned mixture = 4;                    // task classes per segment, each with its own runtime/memory draw
+
+   string vm_type = "LINUX";
+   string gpu = "no";
+   string sla = "SLA2";
+   string cpu = "X86";
+   string task_type = "WEB";
+   uint64_t seed = 1;
+};
+
+
+struct RateSegment {
+   Time_t start;
+   Time_t end;
+   double rate;                // arrivals per second
+};
+
+
+// Walks one workload class and hands out its constant-rate segments lazily
+class SegmentGenerator {
+public:
+   explicit SegmentGenerator(const WorkloadClass & workload);
+   bool Next(RateSegment & segment);
+private:
+   const WorkloadClass & workload;
+   Xoshiro256 rng;
+   Time_t now;
+   bool bursty = false;
+   Time_t state_end = 0;
+   size_t trace_index = 0;
+
+   double RateAt(Time_t time);
+   Time_t Boundary(Time_t time);
+};
+
+
+// Reads a workload spec. Machine classes are kept verbatim for the output.
+void ReadWorkloadSpec(const string & filename, vector<WorkloadClass> & workloads, string & machine_classes);
+
+// Writes the machine classes followed by task classes for every segment.
+// Returns the expected number of tasks.
+double WriteWorkload(ostream & out, const vector<WorkloadClass> & workloads, const string & machine_classes);
+
+
+#endif /* WorkloadGen_hpp */
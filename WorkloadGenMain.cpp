@@ -0,0 +1,40 @@
+//
+//  WorkloadGenMain.cpp
+//  CloudSim
+//
+//  Usage: workloadgen spec_file [output_file]
+//  Writes a simulator input file (to stdout by default) from a workload spec.
+//
+
+
+#include <fstream>
+#include <iostream>
+
+#include "WorkloadGen.hpp"
+
+
+int main(int argc, char * argv[]) {
+   if (argc < 2) {
+      cerr << "Usage: " << argv[0] << " spec_file [output_file]" << endl;
+      return 1;
+   }
+
+   try {
+      vector<WorkloadClass> workloads;
+      string machine_classes;
+      ReadWorkloadSpec(argv[1], workloads, machine_classes);
+
+      double expected_tasks;
+      if (argc > 2) {
+         ofstream out(argv[2]);
+         expected_tasks = WriteWorkload(out, workloads, machine_classes);
+      } else {
+         expected_tasks = WriteWorkload(cout, workloads, machine_classes);
+      }
+      cerr << "workloadgen: about " << uint64_t(expected_tasks) << " tasks" << endl;
+   } catch (const exception & e) {
+      cerr << e.what() << endl;
+      return 1;
+   }
+   return 0;
+}
@@ -10,7 +10,6 @@
 #include <climits>
 
 
-static bool migrating = false;
 static unsigned active_machines = 16;
 
 
@@ -49,14 +48,14 @@ void Scheduler::Init() {
 
    for (unsigned i = 0; i < total_machines; i++) {
        machines.push_back(i);
-       powered_on.insert(i); // Track that machine is on
+       powered_on.Insert(i); // Track that machine is on
        MachineInfo_t machine_info = Machine_GetInfo(i); 
        VMId_t vm = VM_Create(GetDefaultVMForCPU(machine_info.cpu), machine_info.cpu);
        VM_Attach(vm, i);
 
 
        vms.push_back(vm);
-       vm_to_machine[vm] = i;
+       machine_vms.Append(i, vm);
    }
 
 
@@ -102,7 +101,7 @@ void Scheduler::NewTask(Time_t now, TaskId_t task_id) {
 
     if (best_vm != VMId_t(-1)) {
         VM_AddTask(best_vm, task_id, priority);
-        task_to_vm[task_id] = best_vm;
+        tasks.Insert(task_info, best_vm);
 
         SimOutput("NewTask(): Assigned task " + to_string(task_id) +
                   " (SLA " + to_string(task_info.required_sla) + ") to existing VM " +
@@ -119,10 +118,11 @@ void Scheduler::NewTask(Time_t now, TaskId_t task_id) {
 
         VMId_t new_vm = VM_Create(task_info.required_vm, task_info.required_cpu);
         VM_Attach(new_vm, machine_id);
+        machine_vms.Append(machine_id, new_vm);
         VM_AddTask(new_vm, task_id, priority);
 
         vms.push_back(new_vm);
-        task_to_vm[task_id] = new_vm;
+        tasks.Insert(task_info, new_vm);
 
         SimOutput("NewTask(): Created VM " + to_string(new_vm) + " on machine " +
                   to_string(machine_id) + " for task " + to_string(task_id), 2);
@@ -136,11 +136,12 @@ void Scheduler::NewTask(Time_t now, TaskId_t task_id) {
             Machine_SetState(machine, S0);
             VMId_t new_vm = VM_Create(task_info.required_vm, task_info.required_cpu);
             VM_Attach(new_vm, machine);
+            machine_vms.Append(machine, new_vm);
             VM_AddTask(new_vm, task_id, priority);
 
             vms.push_back(new_vm);
             machines.push_back(machine);
-            task_to_vm[task_id] = new_vm;
+            tasks.Insert(task_info, new_vm);
 
             SimOutput("NewTask(): Powered on machine " + to_string(machine) + " for task " + to_string(task_id), 2);
             return;
@@ -190,12 +191,16 @@ void Scheduler::TaskComplete(Time_t now, TaskId_t task_id) {
 
    SimOutput("Scheduler::TaskComplete(): Task " + to_string(task_id) + " is complete at " + to_string(now), 4);
 
-    VMId_t vm = task_to_vm[task_id];
-    MachineId_t machine = vm_to_machine[vm];
+    TaskHandle_t handle = tasks.Find(task_id);
+    if (handle == INVALID_TASK_HANDLE) return;
+    VMId_t vm = tasks.Get(handle).vm_id;
+    tasks.Release(task_id, now);
+    MachineId_t machine = machine_vms.OwnerOf(vm);
     MachineInfo_t machine_info = Machine_GetInfo(machine);
 
     if (machine_info.active_tasks == 0 && machine_info.active_vms == 0 && machine_info.s_state == S0) {
         VM_Shutdown(vm);
+        machine_vms.Remove(vm);
         Machine_SetState(machine, S5);
     }
    SimOutput("Scheduler::TaskComplete(): Task " + to_string(task_id) + " is complete at " + to_string(now), 4);
@@ -236,7 +241,6 @@ void MigrationDone(Time_t time, VMId_t vm_id) {
    // The function is called on to alert you that migration is complete
    SimOutput("MigrationDone(): Migration of VM " + to_string(vm_id) + " was completed at time " + to_string(time), 4);
    Scheduler.MigrationComplete(time, vm_id);
-   migrating = false;
 }
 
 
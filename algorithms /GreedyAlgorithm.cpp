@@ -10,7 +10,6 @@
 #include <climits>
 
 
-static bool migrating = false;
 static unsigned active_machines = 16;
 
 
@@ -47,14 +46,14 @@ void Scheduler::Init() {
 
    for (unsigned i = 0; i < total_machines; i++) {
        machines.push_back(i);
-       powered_on.insert(i); // Track that machine is on
+       powered_on.Insert(i); // Track that machine is on
        MachineInfo_t machine_info = Machine_GetInfo(i); 
        VMId_t vm = VM_Create(GetDefaultVMForCPU(machine_info.cpu), machine_info.cpu);
        VM_Attach(vm, i);
 
 
        vms.push_back(vm);
-       vm_to_machine[vm] = i;
+       machine_vms.Append(i, vm);
    }
 
    SimOutput("Scheduler::Init(): Initialized " + to_string(active_machines) + " X86 machines with VMs.", 3);
@@ -110,6 +109,7 @@ void Scheduler::NewTask(Time_t now, TaskId_t task_id) {
       
       VMId_t new_vm = VM_Create(task_info.required_vm, task_info.required_cpu);
       VM_Attach(new_vm, machine_id);
+      machine_vms.Append(machine_id, new_vm);
       VM_AddTask(new_vm, task_id, task_info.priority);
       vms.push_back(new_vm);
   
@@ -126,6 +126,7 @@ void Scheduler::NewTask(Time_t now, TaskId_t task_id) {
          VMId_t new_vm = VM_Create(task_info.required_vm, task_info.required_cpu);
          SimOutput("went wrong at this attach", 3);
          VM_Attach(new_vm, machine);
+         machine_vms.Append(machine, new_vm);
          VM_AddTask(new_vm, task_id, task_info.priority);
 
          vms.push_back(new_vm);
@@ -215,7 +216,6 @@ void MigrationDone(Time_t time, VMId_t vm_id) {
    // The function is called on to alert you that migration is complete
    SimOutput("MigrationDone(): Migration of VM " + to_string(vm_id) + " was completed at time " + to_string(time), 4);
    Scheduler.MigrationComplete(time, vm_id);
-   migrating = false;
 }
 
 
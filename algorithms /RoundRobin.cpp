@@ -10,7 +10,6 @@
 #include <climits>
 
 
-static bool migrating = false;
 static unsigned active_machines = 16;
 static unsigned round_robin_pointer = 0;
 
@@ -49,14 +48,14 @@ void Scheduler::Init() {
 
    for (unsigned i = 0; i < total_machines; i++) {
        machines.push_back(i);
-       powered_on.insert(i); // Track that machine is on
+       powered_on.Insert(i); // Track that machine is on
        MachineInfo_t machine_info = Machine_GetInfo(i); 
        VMId_t vm = VM_Create(GetDefaultVMForCPU(machine_info.cpu), machine_info.cpu);
        VM_Attach(vm, i);
 
 
        vms.push_back(vm);
-       vm_to_machine[vm] = i;
+       machine_vms.Append(i, vm);
    }
 
     SimOutput("Scheduler::Init(): Initialized " + to_string(active_machines) + " X86 machines with VMs.", 3);
@@ -83,9 +82,9 @@ void Scheduler::NewTask(Time_t now, TaskId_t task_id) {
       
       VMId_t foundVM;
       bool found_a_vm = false; 
-      for(VMId_t vm_id : vms) {
+      for(VMId_t vm_id : machine_vms.Of(machine_id)) {
          VMInfo_t vm_info = VM_GetInfo(vm_id); 
-         if (vm_info.machine_id == machine_id && vm_info.vm_type == task_info.required_vm) {
+         if (vm_info.vm_type == task_info.required_vm) {
             foundVM = vm_id; 
             found_a_vm = true;
          }
@@ -94,6 +93,7 @@ void Scheduler::NewTask(Time_t now, TaskId_t task_id) {
       if(!found_a_vm) {
          foundVM = VM_Create(task_info.required_vm, task_info.required_cpu);
          VM_Attach(foundVM, machine_id);
+         machine_vms.Append(machine_id, foundVM);
          vms.push_back(foundVM);
       }
 
@@ -116,6 +116,7 @@ void Scheduler::NewTask(Time_t now, TaskId_t task_id) {
       Machine_SetState(machine_id, S0);
       VMId_t new_vm = VM_Create(task_info.required_vm, task_info.required_cpu);
       VM_Attach(new_vm, machine_id);
+      machine_vms.Append(machine_id, new_vm);
       VM_AddTask(new_vm, task_id, task_info.priority);
 
       vms.push_back(new_vm);
@@ -206,7 +207,6 @@ void MigrationDone(Time_t time, VMId_t vm_id) {
    // The function is called on to alert you that migration is complete
    SimOutput("MigrationDone(): Migration of VM " + to_string(vm_id) + " was completed at time " + to_string(time), 4);
    Scheduler.MigrationComplete(time, vm_id);
-   migrating = false;
 }
 
 
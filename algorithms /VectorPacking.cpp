@@ -0,0 +1,547 @@
+//
+//  VectorPacking.cpp
+//  CloudSim
+//
+//  Places tasks by packing vectors: every powered-on host has a load vector
+//  (busy cores, memory and GPU tasks, each as a fraction of the host's
+//  capacity) and every task a demand vector on the same axes. The host a
+//  task goes to is chosen by one of two rules, set by CLOUDSIM_PACKING:
+//
+//    l2  (default)  the host left with the smallest L2 norm of free
+//                   capacity after placing the task, i.e. best fit in all
+//                   dimensions at once
+//    dot            the host whose free capacity has the largest dot
+//                   product with the demand, i.e. the one whose spare room
+//                   is shaped most like the task
+//
+//  Load vectors are kept up to date as tasks start and finish. Awake hosts
+//  are indexed per CPU type and level of core sharing, ordered by free
+//  memory, so a task only ranks the few hosts next to its memory demand
+//  (the tightest fits for l2, the roomiest for dot) and makes no simulator
+//  calls. Hosts with a free core come first; the cores of awake hosts are
+//  shared, up to a limit, before another host is woken. Hosts being woken
+//  take queued tasks while their memory and cores last, so a burst wakes
+//  only as many hosts as it needs. Sleeping hosts are ordered by memory, and
+//  tasks that fit nowhere wait in the admission queue. Hosts whose last task
+//  has finished are put to sleep at the next periodic check.
+//
+
+
+#include "Scheduler.hpp"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <unordered_set>
+
+
+enum PackingRule { L2_NORM, DOT_PRODUCT };
+
+struct HostLoad {
+   unsigned tasks = 0;
+   unsigned memory = 0;
+   unsigned gpu_tasks = 0;
+   unsigned vm_types = 0;      // bit per VMType_t attached
+};
+
+// Tasks per core beyond the first that a host may take; past that a sleeping
+// host is woken, or the task waits in the admission queue. Tasks with a deadline
+// share only where they still meet it, and past that take the least shared awake
+// host rather than wait for one to wake.
+static const unsigned SHARING = 2;
+// Hosts ranked per sharing level, next to the task's memory demand
+static const unsigned CANDIDATES = 8;
+static const unsigned NOT_FILED = UINT_MAX;
+
+typedef std::set<std::pair<unsigned, MachineId_t>> HostOrder;
+
+static PackingRule packing_rule = L2_NORM;
+static vector<const MachineClass *> classes;
+static vector<HostLoad> loads;
+static IdSet<MachineId_t> awake[NUM_CPU_TYPES];     // powered on and taking tasks
+static HostOrder by_free[NUM_CPU_TYPES][SHARING + 1];   // awake hosts by free memory, per sharing level
+static vector<std::pair<unsigned, unsigned>> filed; // sharing level and free memory each host is filed under
+static HostOrder sleepers[NUM_CPU_TYPES][2];        // in S5 by most memory first, without and with GPUs
+static IdMap<MachineId_t, HostLoad> promised;       // to queued tasks, on hosts being woken
+static vector<MachineId_t> waking_hosts[NUM_CPU_TYPES];
+static std::unordered_set<TaskId_t> gpu_tasks;      // live tasks charged to a host's GPU
+static IdSet<MachineId_t> emptied;                  // ran out of tasks since the last check
+static uint64_t wakes = 0;
+static uint64_t shared = 0;
+
+
+static Priority_t PriorityOf(SLAType_t sla) {
+   switch (sla) {
+      case SLA0: return HIGH_PRIORITY;
+      case SLA1: return HIGH_PRIORITY;
+      case SLA2: return MID_PRIORITY;
+      default:   return LOW_PRIORITY;
+   }
+}
+
+
+VMType_t Scheduler::GetDefaultVMForCPU(CPUType_t cpu_type) {
+   switch (cpu_type) {
+      case X86:
+         return LINUX;
+      case POWER:
+         return AIX;
+      case ARM:
+         return WIN;
+      default:
+         SimOutput("Scheduler::GetDefaultVMForCPU(): Unknown CPU type " + to_string(cpu_type), 1);
+         return VMType_t(-1); // Fallback VM type
+   }
+}
+
+
+static unsigned SharingLevel(const MachineClass & host, const HostLoad & load) {
+   return load.tasks < host.num_cpus ? 0 : (load.tasks - host.num_cpus) / host.num_cpus + 1;
+}
+
+
+static void Unfile(MachineId_t machine_id) {
+   if (filed[machine_id].first == NOT_FILED) return;
+   by_free[classes[machine_id]->cpu][filed[machine_id].first].erase({filed[machine_id].second, machine_id});
+   filed[machine_id].first = NOT_FILED;
+}
+
+
+// Files an awake host under its current load; hosts past the sharing limit are left out
+static void File(MachineId_t machine_id) {
+   Unfile(machine_id);
+   const MachineClass & host = *classes[machine_id];
+   const HostLoad & load = loads[machine_id];
+   unsigned level = SharingLevel(host, load);
+   if (!awake[host.cpu].Contains(machine_id) || level > SHARING) return;
+   unsigned free_memory = host.memory_size - min(load.memory, host.memory_size);
+   filed[machine_id] = {level, free_memory};
+   by_free[host.cpu][level].insert({free_memory, machine_id});
+}
+
+
+// Re-reads what the simulator charges the host and refiles it; GPU tasks are counted here
+static void Refresh(MachineId_t machine_id) {
+   MachineInfo_t m_info = Machine_GetInfo(machine_id);
+   loads[machine_id].tasks = m_info.active_tasks;
+   loads[machine_id].memory = m_info.memory_used;
+   File(machine_id);
+}
+
+
+static void AddSleeper(MachineId_t machine_id) {
+   const MachineClass & host = *classes[machine_id];
+   sleepers[host.cpu][host.gpus].insert({UINT_MAX - host.memory_size, machine_id});
+}
+
+
+// Lower is better. Infinity when the task does not fit.
+static double Score(const MachineClass & host, const HostLoad & load, const TaskInfo_t & task_info, unsigned memory) {
+   if (load.memory + memory > host.memory_size) return INFINITY;
+
+   double cores = double(host.num_cpus);
+   double used[3] = {load.tasks / cores, double(load.memory) / host.memory_size, load.gpu_tasks / cores};
+   double demand[3] = {1 / cores, double(memory) / host.memory_size, task_info.gpu_capable ? 1 / cores : 0};
+   unsigned dimensions = host.gpus ? 3 : 2;
+
+   double score = 0;
+   for (unsigned d = 0; d < dimensions; d++) {
+      double free = max(1 - used[d], 0.0);
+      if (packing_rule == L2_NORM) {
+         double left = max(free - demand[d], 0.0);
+         score += left * left;
+      } else {
+         score -= demand[d] * free;
+      }
+   }
+   return score;
+}
+
+
+// Whether the task still meets its target on the host once it shares the cores.
+// The policy keeps every core at P0.
+static bool OnTime(const MachineClass & host, const HostLoad & load, const TaskInfo_t & task_info, Time_t now) {
+   double runtime = double(task_info.remaining_instructions) / host.mips[P0];
+   unsigned sharing = load.tasks + 1;
+   if (sharing > host.num_cpus) {
+      runtime = runtime * sharing / host.num_cpus;
+   }
+   return now + Time_t(runtime) <= task_info.target_completion;
+}
+
+
+// Hosts with a free core, then hosts whose cores are shared by more tasks each, from
+// sharing level `lowest` to `highest`. Within a level only the hosts next to the task's
+// memory demand are ranked: the tightest fits for l2, the roomiest hosts for dot. With
+// `on_time`, shared hosts on which the task would miss its target are passed over.
+// Returns the best host of the first level that has one, and that level.
+static MachineId_t Pack(const TaskInfo_t & task_info, Time_t now, unsigned lowest, unsigned highest, bool on_time,
+                        unsigned & level) {
+   MachineId_t best = MachineId_t(-1);
+   for (level = lowest; level <= highest; level++) {
+      const HostOrder & hosts = by_free[task_info.required_cpu][level];
+      double best_score = INFINITY;
+      auto rank = [&](MachineId_t machine_id) {
+         const HostLoad & load = loads[machine_id];
+         if (on_time && level > 0 && !OnTime(*classes[machine_id], load, task_info, now)) return;
+         bool has_vm = load.vm_types & (1u << task_info.required_vm);
+         unsigned memory = task_info.required_memory + (has_vm ? 0 : VM_MEMORY_OVERHEAD);
+         double score = Score(*classes[machine_id], load, task_info, memory);
+         if (score < best_score) {
+            best = machine_id;
+            best_score = score;
+         }
+      };
+      unsigned ranked = 0;
+      if (packing_rule == L2_NORM) {
+         for (auto it = hosts.lower_bound({task_info.required_memory, 0}); it != hosts.end() && ranked < CANDIDATES; it++, ranked++) {
+            rank(it->second);
+         }
+      } else {
+         for (auto it = hosts.rbegin(); it != hosts.rend() && it->first >= task_info.required_memory && ranked < CANDIDATES;
+              it++, ranked++) {
+            rank(it->second);
+         }
+      }
+      if (best != MachineId_t(-1)) return best;
+   }
+   return best;
+}
+
+
+// Awake host of the task's CPU type with memory for it and the fewest tasks per core,
+// whatever its sharing level. Scans the awake hosts, so it is the last resort.
+static MachineId_t LeastShared(const TaskInfo_t & task_info) {
+   MachineId_t best = MachineId_t(-1);
+   double best_sharing = INFINITY;
+   for (MachineId_t machine_id : awake[task_info.required_cpu]) {
+      const MachineClass & host = *classes[machine_id];
+      const HostLoad & load = loads[machine_id];
+      bool has_vm = load.vm_types & (1u << task_info.required_vm);
+      unsigned memory = task_info.required_memory + (has_vm ? 0 : VM_MEMORY_OVERHEAD);
+      if (load.memory + memory > host.memory_size) continue;
+      double sharing = double(load.tasks + 1) / host.num_cpus;
+      if (sharing < best_sharing) {
+         best = machine_id;
+         best_sharing = sharing;
+      }
+   }
+   return best;
+}
+
+
+void Scheduler::Init() {
+   unsigned total_machines = Machine_GetTotal();
+   SimOutput("Scheduler::Init(): Total number of machines is " + to_string(total_machines), 3);
+   SimOutput("Scheduler::Init(): Initializing scheduler", 1);
+
+   const char * rule = getenv("CLOUDSIM_PACKING");
+   packing_rule = rule != nullptr && strcmp(rule, "dot") == 0 ? DOT_PRODUCT : L2_NORM;
+
+   machine_classes.Init(total_machines);
+   loads.assign(total_machines, HostLoad());
+   filed.assign(total_machines, {NOT_FILED, 0});
+   classes.resize(total_machines);
+   for (unsigned i = 0; i < total_machines; i++) {
+      MachineId_t machine_id = MachineId_t(i);
+      const MachineClass & machine_class = machine_classes.OfMachine(machine_id);
+      classes[machine_id] = &machine_class;
+      machines.push_back(machine_id);
+      powered_on.Insert(machine_id);
+      awake[machine_class.cpu].Insert(machine_id);
+
+      VMId_t vm = VM_Create(GetDefaultVMForCPU(machine_class.cpu), machine_class.cpu);
+      VM_Attach(vm, machine_id);
+      vms.push_back(vm);
+      machine_vms.Append(machine_id, vm);
+      loads[machine_id].vm_types = 1u << GetDefaultVMForCPU(machine_class.cpu);
+      Refresh(machine_id);
+   }
+
+   SimOutput("Scheduler::Init(): Packing by " + string(packing_rule == L2_NORM ? "L2 norm" : "dot product"), 1);
+}
+
+
+void Scheduler::MigrationComplete(Time_t time, VMId_t vm_id) {
+   async.Migrated(time, vm_id);
+}
+
+
+// Hosts put to sleep can be woken again once they are down
+void Scheduler::StateChangeComplete(Time_t now, MachineId_t machine_id) {
+   if (!powered_on.Contains(machine_id) && Machine_GetInfo(machine_id).s_state == S5) {
+      AddSleeper(machine_id);
+   }
+   async.StateChanged(now, machine_id);
+}
+
+
+// Not used by this policy
+Plan Scheduler::Relocate(VMId_t vm_id, MachineId_t destination) {
+   co_await async.Migrate(vm_id, destination);
+   machine_vms.Append(destination, vm_id);
+}
+
+
+VMId_t Scheduler::AcquireVM(const TaskInfo_t & task_info, MachineId_t machine_id) {
+   for (VMId_t vm : machine_vms.Of(machine_id)) {
+      if (VM_GetInfo(vm).vm_type == task_info.required_vm) return vm;
+   }
+   VMId_t vm = VM_Create(task_info.required_vm, task_info.required_cpu);
+   VM_Attach(vm, machine_id);
+   vms.push_back(vm);
+   machine_vms.Append(machine_id, vm);
+   loads[machine_id].vm_types |= 1u << task_info.required_vm;
+   return vm;
+}
+
+
+bool Scheduler::PlaceOnMachine(const TaskInfo_t & task_info, MachineId_t machine_id) {
+   VMId_t vm = AcquireVM(task_info, machine_id);
+   VM_AddTask(vm, task_info.task_id, PriorityOf(task_info.required_sla));
+   tasks.Insert(task_info, vm);
+   if (task_info.gpu_capable && machine_classes.OfMachine(machine_id).gpus) {
+      gpu_tasks.insert(task_info.task_id);
+      loads[machine_id].gpu_tasks++;
+   }
+   Refresh(machine_id);
+   return true;
+}
+
+
+// Wakes the host, then places the task on it along with the tasks queued for it meanwhile
+Plan Scheduler::PowerOnFor(MachineId_t machine_id, TaskId_t task_id) {
+   co_await async.WakeMachine(machine_id);
+   CPUType_t cpu = machine_classes.OfMachine(machine_id).cpu;
+   promised.Erase(machine_id);
+   waking_hosts[cpu].erase(std::find(waking_hosts[cpu].begin(), waking_hosts[cpu].end(), machine_id));
+   awake[cpu].Insert(machine_id);
+   Refresh(machine_id);
+   PlaceOnMachine(GetTaskInfo(task_id), machine_id);
+   DrainPending(machine_id);
+}
+
+
+void Scheduler::NewTask(Time_t now, TaskId_t task_id) {
+   TaskInfo_t task_info = GetTaskInfo(task_id);
+   CPUType_t cpu = task_info.required_cpu;
+
+   // Hosts with a free core first, then shared ones; SLA0 to SLA2 tasks only share
+   // where they still meet their target
+   bool deadline = task_info.required_sla != SLA3;
+   unsigned level;
+   MachineId_t best = Pack(task_info, now, 0, SHARING, deadline, level);
+   if (best != MachineId_t(-1)) {
+      if (level > 0) shared++;
+      PlaceOnMachine(task_info, best);
+      SimOutput("NewTask(): Packed task " + to_string(task_id) + " on machine " + to_string(best), 3);
+      return;
+   }
+
+   // Waking a host takes far longer than sharing a core delays a task, so a task
+   // with a deadline goes to the awake host with the fewest tasks per core, past
+   // the sharing limit if need be, before it waits for a wake-up
+   if (deadline) {
+      best = LeastShared(task_info);
+      if (best != MachineId_t(-1)) {
+         shared++;
+         PlaceOnMachine(task_info, best);
+         SimOutput("NewTask(): Shared a core on machine " + to_string(best) + " for task " + to_string(task_id), 3);
+         return;
+      }
+   }
+
+   // A host already being woken takes the task while its memory and cores last
+   unsigned needed = task_info.required_memory + VM_MEMORY_OVERHEAD;
+   for (MachineId_t machine_id : waking_hosts[cpu]) {
+      const MachineClass & host = *classes[machine_id];
+      HostLoad & promise = promised.Get(machine_id);
+      if (promise.tasks >= host.num_cpus || promise.memory + needed > host.memory_size) continue;
+      promise.tasks++;
+      promise.memory += needed;
+      pending_tasks.Push(task_info, task_info.target_completion);
+      SimOutput("NewTask(): Task " + to_string(task_id) + " waits for machine " + to_string(machine_id) + " to wake up", 2);
+      return;
+   }
+
+   // Wake a sleeping host: one with a GPU for GPU tasks, then the one with the most memory
+   MachineId_t sleeper = MachineId_t(-1);
+   for (bool gpus : {task_info.gpu_capable, !task_info.gpu_capable}) {
+      const HostOrder & hosts = sleepers[cpu][gpus];
+      if (!hosts.empty() && classes[hosts.begin()->second]->memory_size >= needed) {
+         sleeper = hosts.begin()->second;
+         break;
+      }
+   }
+   if (sleeper != MachineId_t(-1)) {
+      sleepers[cpu][classes[sleeper]->gpus].erase(sleepers[cpu][classes[sleeper]->gpus].begin());
+      powered_on.Insert(sleeper);
+      promised[sleeper] = {1, needed, 0, 0};
+      waking_hosts[cpu].push_back(sleeper);
+      wakes++;
+      PowerOnFor(sleeper, task_id);
+      SimOutput("NewTask(): Woke machine " + to_string(sleeper) + " for task " + to_string(task_id), 2);
+      return;
+   }
+
+   // The task waits for a host to free a core or memory
+   pending_tasks.Push(task_info, task_info.target_completion);
+   SimOutput("NewTask(): Queued task " + to_string(task_id), 2);
+}
+
+
+// Places queued tasks that now fit in the host's memory on its free cores. Only
+// free cores: a task added to a shared core from inside the completion callback
+// is started by the simulator alongside the core's next queued task, which
+// aborts the run ("CPU was already in C0 state").
+void Scheduler::DrainPending(MachineId_t machine_id) {
+   const MachineClass & host = machine_classes.OfMachine(machine_id);
+   if (pending_tasks.Empty(host.cpu) || !powered_on.Contains(machine_id)) return;
+   PendingTask task;
+   while (loads[machine_id].tasks < host.num_cpus &&
+          pending_tasks.PopFitting(host.cpu, host.memory_size - min(loads[machine_id].memory, host.memory_size), task)) {
+      PlaceOnMachine(GetTaskInfo(task.task_id), machine_id);
+   }
+}
+
+
+void Scheduler::PeriodicCheck(Time_t now) {
+   // Hosts that ran out of tasks go to sleep; hosts that never had any stay up for the next burst,
+   // and so does the last awake host of each CPU type, as sleeping hosts are slow to come back
+   IdSet<MachineId_t> idle;
+   idle.Swap(emptied);
+   if (idle.Empty()) return;
+   unsigned cores[NUM_CPU_TYPES] = {};
+   unsigned busy[NUM_CPU_TYPES] = {};
+   for (unsigned cpu = 0; cpu < NUM_CPU_TYPES; cpu++) {
+      for (MachineId_t machine_id : awake[cpu]) {
+         cores[cpu] += classes[machine_id]->num_cpus;
+         busy[cpu] += loads[machine_id].tasks;
+      }
+   }
+   for (MachineId_t machine_id : idle) {
+      if (loads[machine_id].tasks > 0 || !powered_on.Contains(machine_id)) continue;
+      const MachineClass & host = *classes[machine_id];
+      IdSet<MachineId_t> & peers = awake[host.cpu];
+      if (peers.Size() <= 1) continue;
+      // The hosts left awake keep a free core for every busy one, so the load can
+      // double in the time a sleeping host takes to come back
+      if (2 * busy[host.cpu] > cores[host.cpu] - host.num_cpus) {
+         emptied.Insert(machine_id);
+         continue;
+      }
+      cores[host.cpu] -= host.num_cpus;
+      while (machine_vms.Of(machine_id).begin() != machine_vms.Of(machine_id).end()) {
+         VMId_t vm = *machine_vms.Of(machine_id).begin();
+         VM_Shutdown(vm);
+         machine_vms.Remove(vm);
+      }
+      loads[machine_id].vm_types = 0;
+      peers.Erase(machine_id);
+      Unfile(machine_id);
+      powered_on.Erase(machine_id);
+      Machine_SetState(machine_id, S5);
+   }
+}
+
+
+void Scheduler::Shutdown(Time_t time) {
+   for (MachineId_t machine_id : machines) {
+      if (Machine_GetInfo(machine_id).s_state != S0) continue;
+      for (VMId_t vm : machine_vms.Of(machine_id)) {
+         VM_Shutdown(vm);
+      }
+   }
+   SimOutput("SimulationComplete(): Finished!", 4);
+   SimOutput("SimulationComplete(): Time is " + to_string(time), 4);
+   SimOutput("Total Energy: " + to_string(Machine_GetClusterEnergy()) + " KW-Hour", 1);
+   SimOutput("Vector packing: " + to_string(wakes) + " hosts woken, " + to_string(shared) + " tasks on shared cores, " +
+             to_string(pending_tasks.Size()) + " never placed", 1);
+   SimOutput("SLA0: " + to_string(GetSLAReport(SLA0)) + "%", 1);
+   SimOutput("SLA1: " + to_string(GetSLAReport(SLA1)) + "%", 1);
+   SimOutput("SLA2: " + to_string(GetSLAReport(SLA2)) + "%", 1);
+   SimOutput("SLA3: best-effort", 1);
+}
+
+
+void Scheduler::TaskComplete(Time_t now, TaskId_t task_id) {
+   SimOutput("Scheduler::TaskComplete(): Task " + to_string(task_id) + " is complete at " + to_string(now), 4);
+
+   TaskHandle_t handle = tasks.Find(task_id);
+   if (handle == INVALID_TASK_HANDLE) return;
+   MachineId_t machine_id = machine_vms.OwnerOf(tasks.Get(handle).vm_id);
+   tasks.Release(task_id, now);
+   if (gpu_tasks.erase(task_id)) loads[machine_id].gpu_tasks--;
+   Refresh(machine_id);
+   DrainPending(machine_id);
+   if (loads[machine_id].tasks == 0) emptied.Insert(machine_id);
+}
+
+
+// Public interface below
+
+
+static Scheduler Scheduler;
+
+
+void InitScheduler() {
+   SimOutput("InitScheduler(): Initializing scheduler", 4);
+   Scheduler.Init();
+}
+
+
+void HandleNewTask(Time_t time, TaskId_t task_id) {
+   SimOutput("HandleNewTask(): Received new task " + to_string(task_id) + " at time " + to_string(time), 4);
+   Scheduler.NewTask(time, task_id);
+}
+
+
+void HandleTaskCompletion(Time_t time, TaskId_t task_id) {
+   SimOutput("HandleTaskCompletion(): Task " + to_string(task_id) + " completed at time " + to_string(time), 4);
+   Scheduler.TaskComplete(time, task_id);
+}
+
+
+void MemoryWarning(Time_t time, MachineId_t machine_id) {
+   // The simulator is alerting you that machine identified by machine_id is overcommitted
+   SimOutput("MemoryWarning(): Overflow at " + to_string(machine_id) + " was detected at time " + to_string(time), 0);
+}
+
+
+void MigrationDone(Time_t time, VMId_t vm_id) {
+   SimOutput("MigrationDone(): Migration of VM " + to_string(vm_id) + " was completed at time " + to_string(time), 4);
+   Scheduler.MigrationComplete(time, vm_id);
+}
+
+
+void SchedulerCheck(Time_t time) {
+   SimOutput("SchedulerCheck(): SchedulerCheck() called at " + to_string(time), 4);
+   Scheduler.PeriodicCheck(time);
+}
+
+
+void SimulationComplete(Time_t time) {
+   // This function is called before the simulation terminates Add whatever you feel like.
+   cout << "SLA violation report" << endl;
+   cout << "SLA0: " << GetSLAReport(SLA0) << "%" << endl;
+   cout << "SLA1: " << GetSLAReport(SLA1) << "%" << endl;
+   cout << "SLA2: " << GetSLAReport(SLA2) << "%" << endl;     // SLA3 do not have SLA violation issues
+   cout << "Total Energy " << Machine_GetClusterEnergy() << "KW-Hour" << endl;
+   cout << "Simulation run finished in " << double(time)/1000000 << " seconds" << endl;
+   SimOutput("SimulationComplete(): Simulation finished at time " + to_string(time), 4);
+
+   Scheduler.Shutdown(time);
+}
+
+
+void SLAWarning(Time_t time, TaskId_t task_id) {
+   SetTaskPriority(task_id, HIGH_PRIORITY);
+}
+
+
+void StateChangeComplete(Time_t time, MachineId_t machine_id) {
+   // Called in response to an earlier request to change the state of a machine
+   Scheduler.StateChangeComplete(time, machine_id);
+}
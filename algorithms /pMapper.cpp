@@ -9,7 +9,6 @@
 #include <climits>
 #include <algorithm>
 
-static bool migrating = false;
 static unsigned active_machines = 16;
 
 VMType_t Scheduler::GetDefaultVMForCPU(CPUType_t cpu_type) {
@@ -48,9 +47,7 @@ void Scheduler::Init() {
         VMId_t vm = VM_Create(GetDefaultVMForCPU(machine_info.cpu), machine_info.cpu);
         vms.push_back(vm);
 
-        //used AI here to know how to push elements onto a hashmap in C++ 
-        machinesToVMs[machines[i]] = {};
-        machinesToVMs[machines[i]].push_back(vms[i]);
+        machine_vms.Append(machines[i], vms[i]);
         VM_Attach(vm, i);
  
     }
@@ -65,13 +62,33 @@ void Scheduler::Init() {
 }
 
 void Scheduler::MigrationComplete(Time_t time, VMId_t vm_id) {
-    // Update your data structure. The VM now can receive new tasks
-    auto it = std::find(pending_vms.begin(), pending_vms.end(), vm_id);
+    // Resumes the plan that moved the VM
+    async.Migrated(time, vm_id);
+}
 
-    if (it != pending_vms.end()) {
-        pending_vms.erase(it);
-    }
+void Scheduler::StateChangeComplete(Time_t now, MachineId_t machine_id) {
+    async.StateChanged(now, machine_id);
+}
+
+// Moves a VM to a busier machine; NewTask() does not place on it until it has arrived
+Plan Scheduler::Relocate(VMId_t vm_id, MachineId_t destination) {
+    pending_vms.Insert(vm_id);
+    co_await async.Migrate(vm_id, destination);
+    // The VM now can receive new tasks
+    pending_vms.Erase(vm_id);
+    machine_vms.Append(destination, vm_id);
+}
 
+// Wakes a sleeping machine and places the task on it once it is up
+Plan Scheduler::PowerOnFor(MachineId_t machine_id, TaskId_t task_id) {
+    co_await async.WakeMachine(machine_id);
+    TaskInfo_t task_info = GetTaskInfo(task_id);
+    VMId_t new_vm = VM_Create(task_info.required_vm, task_info.required_cpu);
+    machine_vms.Append(machine_id, new_vm);
+    VM_Attach(new_vm, machine_id);
+    VM_AddTask(new_vm, task_id, task_info.priority);
+
+    vms.push_back(new_vm);
 }
 
 void Scheduler::NewTask(Time_t now, TaskId_t task_id) { 
@@ -87,11 +104,10 @@ void Scheduler::NewTask(Time_t now, TaskId_t task_id) {
       MachineInfo_t m_info = Machine_GetInfo(top); 
       unsigned available_memory = m_info.memory_size - m_info.memory_used;
       if (m_info.s_state == S0 && m_info.cpu == task_info.required_cpu && (available_memory >= task_info.required_memory + VM_MEMORY_OVERHEAD)) {
-         //find a available VM or create one for this machine 
-         for(VMId_t vm : vms) {
+         //find a available VM or create one for this machine; VMs being migrated are not available
+         for(VMId_t vm : machine_vms.Of(top)) {
             VMInfo_t vm_info = VM_GetInfo(vm); 
-            auto migrating = std::find(pending_vms.begin(), pending_vms.end(), vm);
-            if(vm_info.machine_id == top && vm_info.vm_type == task_info.required_vm && migrating != pending_vms.end()) {
+            if(vm_info.vm_type == task_info.required_vm && !pending_vms.Contains(vm)) {
                VM_AddTask(vm, task_id, task_info.priority);
                for(MachineId_t removed_machines: prevMachines) {
                   machineQueue.push(removed_machines); 
@@ -101,7 +117,7 @@ void Scheduler::NewTask(Time_t now, TaskId_t task_id) {
          }
 
          VMId_t new_vm = VM_Create(task_info.required_vm, task_info.required_cpu);
-         machinesToVMs[top].push_back(new_vm); 
+         machine_vms.Append(top, new_vm); 
          VM_Attach(new_vm, top);
          VM_AddTask(new_vm, task_id, task_info.priority);
 
@@ -124,13 +140,8 @@ void Scheduler::NewTask(Time_t now, TaskId_t task_id) {
       MachineInfo_t m_info = Machine_GetInfo(MachineId_t(i)); 
       unsigned available_memory = m_info.memory_size - m_info.memory_used;
       if (m_info.s_state == S5 && m_info.cpu == task_info.required_cpu && (available_memory >= task_info.required_memory + VM_MEMORY_OVERHEAD)) {
-         Machine_SetState(MachineId_t(i), S0);
-         VMId_t new_vm = VM_Create(task_info.required_vm, task_info.required_cpu);
-         machinesToVMs[MachineId_t(i)].push_back(new_vm); 
-         VM_Attach(new_vm, MachineId_t(i));
-         VM_AddTask(new_vm, task_id, task_info.priority);
-
-         vms.push_back(new_vm);
+         PowerOnFor(MachineId_t(i), task_id);
+         break;
       }
    }
 
@@ -182,51 +193,43 @@ void Scheduler::TaskComplete(Time_t now, TaskId_t task_id) {
    TaskInfo_t task_info = GetTaskInfo(task_id); 
    for(MachineId_t curr_machine : lowUtil) {
       unsigned smallest_workload = UINT_MAX; 
-      VMId_t smallest_vm_id = -1; 
-      bool found_vm = false; 
-
-
-
-
-      for(VMId_t vm : machinesToVMs[curr_machine]) {
-         VMInfo_t vm_info = VM_GetInfo(vm); 
-         auto migrating = std::find(pending_vms.begin(), pending_vms.end(), smallest_vm_id);
-         if(migrating != pending_vms.end()) {
-            unsigned this_workload = 0; 
-            for(TaskId_t task : vm_info.active_tasks) {
-               this_workload += GetTaskInfo(task).required_memory; 
-               found_vm = true; 
-            }
+      VMId_t smallest_vm_id = VMId_t(-1); 
+
+      //VMs already on their way to another machine are left alone, and so are
+      //VMs whose tasks would miss their deadline while the VM is in flight.
+      //Until a migration has been timed only best-effort tasks are moved
+      Time_t latency = async.MigrationLatency();
+      for(VMId_t vm : machine_vms.Of(curr_machine)) {
+         if(pending_vms.Contains(vm)) continue;
+         unsigned this_workload = 0; 
+         bool urgent = false;
+         for(TaskId_t task : VM_GetInfo(vm).active_tasks) {
+            TaskInfo_t info = GetTaskInfo(task);
+            this_workload += info.required_memory; 
+            bool deadline = info.required_sla != SLA3;
+            urgent = urgent || (deadline && (latency == 0 || info.target_completion < now + latency));
+         }
+         if(urgent) continue;
 
-            if(this_workload > 0 && this_workload < smallest_workload) {
-               smallest_workload = this_workload; 
-               smallest_vm_id = vm; 
-            }
+         if(this_workload > 0 && this_workload < smallest_workload) {
+            smallest_workload = this_workload; 
+            smallest_vm_id = vm; 
          }
+      }
 
+      if(smallest_vm_id == VMId_t(-1)) {
+         continue; 
+      } 
 
-         if(!found_vm || smallest_vm_id <= 0) {
+
+      //see if we can migrate to a big machine 
+      VMInfo_t vm_info = VM_GetInfo(smallest_vm_id); 
+      for(MachineId_t big_machine : highUtil) {
+         MachineInfo_t m_info = Machine_GetInfo(big_machine);
+         unsigned available_memory = m_info.memory_size - m_info.memory_used;
+         if (m_info.s_state == S0 && m_info.cpu == vm_info.cpu && (available_memory >= smallest_workload + VM_MEMORY_OVERHEAD)) {
+            Relocate(smallest_vm_id, big_machine);
             break; 
-         } 
-
-
-         //see if we can migrate to a big machine 
-         for(MachineId_t big_machine : highUtil) {
-            MachineInfo_t m_info = Machine_GetInfo(big_machine);
-            VMInfo_t vm_info = VM_GetInfo(smallest_vm_id); 
-            unsigned available_memory = m_info.memory_size - m_info.memory_used;
-            if (m_info.s_state == S0 && m_info.cpu == vm_info.cpu && (available_memory >= smallest_workload + VM_MEMORY_OVERHEAD)) {
-               auto it = machinesToVMs.find(curr_machine);
-
-                if (it != machinesToVMs.end()) {
-                    std::vector<VMId_t>& vmList = it->second;
-                    vmList.erase(std::remove(vmList.begin(), vmList.end(), smallest_vm_id), vmList.end());
-                }           
-               pending_vms.push_back(smallest_vm_id); 
-               machinesToVMs[big_machine].push_back(smallest_vm_id); 
-               VM_Migrate(smallest_vm_id, big_machine);
-               break; 
-            }
          }
       }
    }
@@ -268,7 +271,6 @@ void MigrationDone(Time_t time, VMId_t vm_id) {
     // The function is called on to alert you that migration is complete
     SimOutput("MigrationDone(): Migration of VM " + to_string(vm_id) + " was completed at time " + to_string(time), 4);
     Scheduler.MigrationComplete(time, vm_id);
-    migrating = false;
 }
 
 void SchedulerCheck(Time_t time) {
@@ -297,4 +299,5 @@ void SLAWarning(Time_t time, TaskId_t task_id) {
 
 void StateChangeComplete(Time_t time, MachineId_t machine_id) {
     // Called in response to an earlier request to change the state of a machine
+    Scheduler.StateChangeComplete(time, machine_id);
 }